@@ -26,7 +26,7 @@ void DAVUtils::addMembersToGroupCard(shared_ptr<VCard> card, vector<shared_ptr<C
                 }
             }
             if (!found) {
-                card->addProperty(make_shared<VCardProperty>("MEMBER", uuid));
+                card->addProperty(VCardProperty("MEMBER", uuid));
             }
 
         // vcard3 / icloud / fastmail
@@ -38,7 +38,7 @@ void DAVUtils::addMembersToGroupCard(shared_ptr<VCard> card, vector<shared_ptr<C
                 }
             }
             if (!found) {
-                card->addProperty(make_shared<VCardProperty>(X_VCARD3_MEMBER, uuid));
+                card->addProperty(VCardProperty(X_VCARD3_MEMBER, uuid));
             }
         }
     }
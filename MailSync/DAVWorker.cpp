@@ -26,6 +26,8 @@
 
 #include <string>
 #include <set>
+#include <future>
+#include <thread>
 #include <curl/curl.h>
 
 #ifdef _MSC_VER
@@ -117,8 +119,48 @@ struct ParsedContact {
     string email;
     string name;
     bool isGroup;
+    bool valid;
 };
 
+// Below this many cards it's cheaper to parse inline than to spin up workers.
+#define VCARD_PARALLEL_PARSE_THRESHOLD 16
+
+static void parseContactVCards(vector<ParsedContact> & parsed, string accountId) {
+    auto parseRange = [&parsed, accountId](size_t from, size_t to) {
+        for (size_t i = from; i < to; i++) {
+            ParsedContact & p = parsed[i];
+            auto vcard = make_shared<VCard>(p.vcardString);
+            if (vcard->incomplete()) {
+                spdlog::get("logger")->info("Unable to decode vcard: {}", p.vcardString);
+                continue;
+            }
+            p.id = vcard->getUniqueId()->getValue();
+            if (p.id == "") p.id = MailUtils::idForCalendar(accountId, p.href);
+            p.email = vcard->getEmails().front()->getValue();
+            p.name = vcard->getFormattedName()->getValue();
+            if (p.name == "") p.name = vcard->getName()->getValue();
+            p.isGroup = DAVUtils::isGroupCard(vcard);
+            p.valid = true;
+        }
+    };
+
+    size_t workers = std::min<size_t>(4, std::max<unsigned>(1, std::thread::hardware_concurrency()));
+    if (parsed.size() < VCARD_PARALLEL_PARSE_THRESHOLD || workers == 1) {
+        parseRange(0, parsed.size());
+        return;
+    }
+
+    // Each worker parses a disjoint slice of the vector, so no locking is needed.
+    size_t per = (parsed.size() + workers - 1) / workers;
+    vector<std::future<void>> pending;
+    for (size_t from = 0; from < parsed.size(); from += per) {
+        pending.push_back(std::async(std::launch::async, parseRange, from, std::min(parsed.size(), from + per)));
+    }
+    for (auto & f : pending) {
+        f.get();
+    }
+}
+
 struct ParsedCalEvent {
     string etag;
     string href;
@@ -879,77 +921,15 @@ void DAVWorker::runForAddressBook(shared_ptr<ContactBook> ab) {
     }
     
     vector<shared_ptr<Contact>> updatedGroups;
-    
-    for (auto chunk : MailUtils::chunksOfVector(needed, 90)) {
-        string payload = "";
-        for (auto & href : chunk) {
-            payload += "<d:href>" + href + "</d:href>";
-        }
-
-        // Fetch the data
-        auto abDoc = performXMLRequest(ab->url(), "REPORT", "<c:addressbook-multiget xmlns:d=\"DAV:\" xmlns:c=\"urn:ietf:params:xml:ns:carddav\"><d:prop><d:getetag /><c:address-data /></d:prop>" + payload + "</c:addressbook-multiget>");
-
-        // Phase 1: Parse XML and VCard data OUTSIDE the transaction
-        vector<ParsedContact> parsed;
-        int responsesFound = 0;
-
-        abDoc->evaluateXPath("//D:response", ([&](xmlNodePtr node) {
-            responsesFound++;
-            auto etag = abDoc->nodeContentAtXPath(".//D:getetag/text()", node);
-            auto href = abDoc->nodeContentAtXPath(".//D:href/text()", node);
-            auto vcardString = abDoc->nodeContentAtXPath(".//carddav:address-data/text()", node);
-            if (vcardString == "") {
-                logger->info("Received addressbook entry {} with an empty body", etag);
-                return;
-            }
-            auto vcard = make_shared<VCard>(vcardString);
-            if (vcard->incomplete()) {
-                logger->info("Unable to decode vcard: {}", vcardString);
-                return;
-            }
-            string id = vcard->getUniqueId()->getValue();
-            if (id == "") id = MailUtils::idForCalendar(account->id(), href);
-            string email = vcard->getEmails().front()->getValue();
-            string name = vcard->getFormattedName()->getValue();
-            if (name == "") name = vcard->getName()->getValue();
-            bool isGroup = DAVUtils::isGroupCard(vcard);
-            parsed.push_back({id, etag, href, vcardString, email, name, isGroup});
-        }));
-
-        if (responsesFound == 0 && !chunk.empty()) {
-            logger->warn("Multiget for {} hrefs returned 0 D:response nodes - server response may be malformed or empty", chunk.size());
-        }
-
-        // Phase 2: Insert/update contacts and process deletions within the same transaction.
-        // Most of the time, this results in a contact being replaced within a single transaction.
-        {
-            MailStoreTransaction transaction{store, "runForAddressBook"};
-
-            if (deleted.size()) {
-                ingestContactDeletions(ab, deleted);
-                deleted.clear();
-            }
 
-            for (auto & p : parsed) {
-                auto contact = store->find<Contact>(Query().equal("id", p.id));
-                if (!contact) {
-                    contact = make_shared<Contact>(p.id, account->id(), p.email, CONTACT_MAX_REFS, CARDDAV_SYNC_SOURCE);
-                }
-                contact->setInfo(json::object({{"vcf", p.vcardString}, {"href", p.href}}));
-                contact->setName(p.name);
-                contact->setEmail(p.email);
-                contact->setEtag(p.etag);
-                contact->setBookId(ab->id());
-                if (p.isGroup) {
-                    contact->setHidden(true);
-                    updatedGroups.push_back(contact);
-                } else {
-                    store->save(contact.get());
-                }
-            }
-            transaction.commit();
+    // Deletions are processed within the first multiget transaction. Most of the time,
+    // this results in a contact being replaced within a single transaction.
+    ingestContactsFromMultiget(ab, needed, "runForAddressBook", updatedGroups, [&]() {
+        if (deleted.size()) {
+            ingestContactDeletions(ab, deleted);
+            deleted.clear();
         }
-    }
+    });
 
     // Process any remaining deletions if there were no multiget chunks to piggyback on
     if (deleted.size()) {
@@ -1133,69 +1113,7 @@ bool DAVWorker::runForAddressBookWithSyncToken(shared_ptr<ContactBook> ab, int r
     if (!neededHrefs.empty()) {
         std::reverse(neededHrefs.begin(), neededHrefs.end());
 
-        for (auto chunk : MailUtils::chunksOfVector(neededHrefs, 90)) {
-            string payload = "";
-            for (auto & href : chunk) {
-                payload += "<d:href>" + href + "</d:href>";
-            }
-
-            auto abDoc = performXMLRequest(ab->url(), "REPORT",
-                "<c:addressbook-multiget xmlns:d=\"DAV:\" xmlns:c=\"urn:ietf:params:xml:ns:carddav\">"
-                "<d:prop><d:getetag /><c:address-data /></d:prop>" + payload + "</c:addressbook-multiget>");
-
-            // Phase 1: Parse XML and VCard data OUTSIDE the transaction
-            vector<ParsedContact> parsed;
-            int responsesFound = 0;
-
-            abDoc->evaluateXPath("//D:response", ([&](xmlNodePtr node) {
-                responsesFound++;
-                auto etag = abDoc->nodeContentAtXPath(".//D:getetag/text()", node);
-                auto href = abDoc->nodeContentAtXPath(".//D:href/text()", node);
-                auto vcardString = abDoc->nodeContentAtXPath(".//carddav:address-data/text()", node);
-                if (vcardString == "") {
-                    logger->info("Received addressbook entry {} with an empty body", etag);
-                    return;
-                }
-                auto vcard = make_shared<VCard>(vcardString);
-                if (vcard->incomplete()) {
-                    logger->info("Unable to decode vcard: {}", vcardString);
-                    return;
-                }
-                string id = vcard->getUniqueId()->getValue();
-                if (id == "") id = MailUtils::idForCalendar(account->id(), href);
-                string email = vcard->getEmails().front()->getValue();
-                string name = vcard->getFormattedName()->getValue();
-                if (name == "") name = vcard->getName()->getValue();
-                bool isGroup = DAVUtils::isGroupCard(vcard);
-                parsed.push_back({id, etag, href, vcardString, email, name, isGroup});
-            }));
-
-            if (responsesFound == 0 && !chunk.empty()) {
-                logger->warn("Multiget for {} hrefs returned 0 D:response nodes - server response may be malformed or empty", chunk.size());
-                multigetHadEmptyResponse = true;
-            }
-
-            // Phase 2: DB operations INSIDE a short transaction
-            MailStoreTransaction transaction{store, "syncToken:contacts:multiget"};
-            for (auto & p : parsed) {
-                auto contact = store->find<Contact>(Query().equal("id", p.id));
-                if (!contact) {
-                    contact = make_shared<Contact>(p.id, account->id(), p.email, CONTACT_MAX_REFS, CARDDAV_SYNC_SOURCE);
-                }
-                contact->setInfo(json::object({{"vcf", p.vcardString}, {"href", p.href}}));
-                contact->setName(p.name);
-                contact->setEmail(p.email);
-                contact->setEtag(p.etag);
-                contact->setBookId(ab->id());
-                if (p.isGroup) {
-                    contact->setHidden(true);
-                    updatedGroups.push_back(contact);
-                } else {
-                    store->save(contact.get());
-                }
-            }
-            transaction.commit();
-        }
+        multigetHadEmptyResponse = !ingestContactsFromMultiget(ab, neededHrefs, "syncToken:contacts:multiget", updatedGroups);
     }
 
     // Delete removed items by href - load all contacts once, then find matches
@@ -1251,6 +1169,100 @@ bool DAVWorker::runForAddressBookWithSyncToken(shared_ptr<ContactBook> ab, int r
     return true;
 }
 
+bool DAVWorker::ingestContactsFromMultiget(shared_ptr<ContactBook> ab, vector<string> hrefs, string transactionName, vector<shared_ptr<Contact>> & updatedGroups, std::function<void()> inFirstTransaction) {
+    bool allResponsesFound = true;
+
+    auto requestChunk = [this, ab](vector<string> chunk) {
+        string payload = "";
+        for (auto & href : chunk) {
+            payload += "<d:href>" + href + "</d:href>";
+        }
+        return performXMLRequest(ab->url(), "REPORT",
+            "<c:addressbook-multiget xmlns:d=\"DAV:\" xmlns:c=\"urn:ietf:params:xml:ns:carddav\">"
+            "<d:prop><d:getetag /><c:address-data /></d:prop>" + payload + "</c:addressbook-multiget>");
+    };
+
+    // The next chunk is requested while the current one is parsed and written, so the
+    // network is never idle waiting on the database. Only one request is in flight at a
+    // time, so the rate limiting state in performXMLRequest is never shared between threads.
+    auto chunks = MailUtils::chunksOfVector(hrefs, 90);
+    std::future<shared_ptr<DavXML>> nextDoc;
+    if (chunks.size()) {
+        nextDoc = std::async(std::launch::async, requestChunk, chunks[0]);
+    }
+
+    for (size_t i = 0; i < chunks.size(); i++) {
+        auto abDoc = nextDoc.get();
+        if (i + 1 < chunks.size()) {
+            nextDoc = std::async(std::launch::async, requestChunk, chunks[i + 1]);
+        }
+
+        // Phase 1: Parse XML and VCard data OUTSIDE the transaction. The XPath context
+        // isn't thread-safe, so we pull the raw entries here and parse the vCards in parallel.
+        vector<ParsedContact> parsed;
+        int responsesFound = 0;
+
+        abDoc->evaluateXPath("//D:response", ([&](xmlNodePtr node) {
+            responsesFound++;
+            auto etag = abDoc->nodeContentAtXPath(".//D:getetag/text()", node);
+            auto href = abDoc->nodeContentAtXPath(".//D:href/text()", node);
+            auto vcardString = abDoc->nodeContentAtXPath(".//carddav:address-data/text()", node);
+            if (vcardString == "") {
+                logger->info("Received addressbook entry {} with an empty body", etag);
+                return;
+            }
+            parsed.push_back({"", etag, href, vcardString, "", "", false, false});
+        }));
+
+        if (responsesFound == 0 && !chunks[i].empty()) {
+            logger->warn("Multiget for {} hrefs returned 0 D:response nodes - server response may be malformed or empty", chunks[i].size());
+            allResponsesFound = false;
+        }
+
+        parseContactVCards(parsed, account->id());
+
+        vector<string> ids;
+        for (auto & p : parsed) {
+            if (p.valid) ids.push_back(p.id);
+        }
+
+        // Phase 2: DB operations INSIDE a short transaction, with one lookup for the whole chunk
+        MailStoreTransaction transaction{store, transactionName};
+
+        if (i == 0 && inFirstTransaction) {
+            inFirstTransaction();
+        }
+
+        map<string, shared_ptr<Contact>> existing;
+        for (auto & c : store->findLargeSet<Contact>("id", ids)) {
+            existing[c->id()] = c;
+        }
+
+        for (auto & p : parsed) {
+            if (!p.valid) continue;
+            auto contact = existing[p.id];
+            if (!contact) {
+                contact = make_shared<Contact>(p.id, account->id(), p.email, CONTACT_MAX_REFS, CARDDAV_SYNC_SOURCE);
+                existing[p.id] = contact;
+            }
+            contact->setInfo(json::object({{"vcf", p.vcardString}, {"href", p.href}}));
+            contact->setName(p.name);
+            contact->setEmail(p.email);
+            contact->setEtag(p.etag);
+            contact->setBookId(ab->id());
+            if (p.isGroup) {
+                contact->setHidden(true);
+                updatedGroups.push_back(contact);
+            } else {
+                store->save(contact.get());
+            }
+        }
+        transaction.commit();
+    }
+
+    return allResponsesFound;
+}
+
 void DAVWorker::ingestContactDeletions(shared_ptr<ContactBook> ab, vector<string> deleted) {
     if (deleted.size() == 0) {
         return;
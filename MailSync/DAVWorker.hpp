@@ -22,6 +22,7 @@
 
 #include <stdio.h>
 
+#include <functional>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -84,6 +85,7 @@ public:
     void runForAddressBook(shared_ptr<ContactBook> ab);
     bool runForAddressBookWithSyncToken(shared_ptr<ContactBook> ab, int retryCount = 0);
 
+    bool ingestContactsFromMultiget(shared_ptr<ContactBook> ab, vector<string> hrefs, string transactionName, vector<shared_ptr<Contact>> & updatedGroups, std::function<void()> inFirstTransaction = nullptr);
     void ingestContactDeletions(shared_ptr<ContactBook> ab, vector<ETAG> deleted);
     shared_ptr<Contact> ingestAddressDataNode(shared_ptr<DavXML> doc, xmlNodePtr node, bool & isGroup);
     void rebuildContactGroup(shared_ptr<Contact> contact);
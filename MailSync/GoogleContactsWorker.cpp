@@ -50,16 +50,24 @@ void GoogleContactsWorker::run() {
         store->save(book.get());
     }
     
-    auto _contactsLocal = store->findAll<Contact>(Query().equal("accountId", account->id()).equal("source", GOOGLE_SYNC_SOURCE));
-    std::unordered_map<string, shared_ptr<Contact>> contactsLocal;
-    for (const auto c : _contactsLocal) {
-        contactsLocal[c->googleResourceName()] = c;
-    }
-
-    // Fetch all connections
+    // Fetch all connections. Each page is applied in a single transaction and local
+    // contacts are looked up by resource name in the database, so we never hold the
+    // full address book in memory.
     
     string peopleUrl = GOOGLE_PEOPLE_ROOT + "people/me/connections?personFields=" + PERSON_FIELDS + "&pageSize=400";
-    paginateGoogleCollection(peopleUrl, authorization, "gsynctoken-contacts-" + account->id(), ([&](json page) {
+    paginateGoogleCollection(peopleUrl, authorization, "gsynctoken-contacts-" + account->id(), ([&](const json & page) {
+        if (!page.count("connections")) {
+            return;
+        }
+
+        vector<string> resourceNames;
+        for (const auto & conn : page["connections"]) {
+            resourceNames.push_back(conn["resourceName"].get<string>());
+        }
+        auto contactsLocal = findContactsByResourceName(resourceNames);
+
+        MailStoreTransaction transaction{store, "googleContactsPage"};
+
         for (const auto & conn : page["connections"]) {
             auto resourceName = conn["resourceName"].get<string>();
 
@@ -68,6 +76,7 @@ void GoogleContactsWorker::run() {
             // handle deleted contact
             if (conn.count("deleted") && conn["deleted"].get<bool>() && local) {
                 store->remove(local.get());
+                contactsLocal.erase(resourceName);
                 continue;
             }
             
@@ -89,25 +98,28 @@ void GoogleContactsWorker::run() {
             applyJSONToContact(local, conn);
             store->save(local.get());
         }
+
+        transaction.commit();
     }));
     
     // Fetch all groups
-    auto groupsLocal = store->findAll<ContactGroup>(Query().equal("accountId", account->id()));
+    std::unordered_map<string, shared_ptr<ContactGroup>> groupsLocal;
+    for (auto g : store->findAll<ContactGroup>(Query().equal("accountId", account->id()))) {
+        groupsLocal[g->googleResourceName()] = g;
+    }
     
-    paginateGoogleCollection(GOOGLE_PEOPLE_ROOT + "contactGroups?pageSize=400", authorization, "gsynctoken-groups-" + account->id(), ([&](json page) {
+    paginateGoogleCollection(GOOGLE_PEOPLE_ROOT + "contactGroups?pageSize=400", authorization, "gsynctoken-groups-" + account->id(), ([&](const json & page) {
+        if (!page.count("contactGroups")) {
+            return;
+        }
         for (const auto & group : page["contactGroups"]) {
             auto resourceName = group["resourceName"].get<string>();
-            shared_ptr<ContactGroup> local = nullptr;
-            for (auto g : groupsLocal) {
-                if (g->googleResourceName() == resourceName) {
-                    local = g;
-                    break;
-                }
-            }
+            shared_ptr<ContactGroup> local = groupsLocal.count(resourceName) ? groupsLocal[resourceName] : nullptr;
 
             // handle deleted group
             if (group.count("metadata") && group["metadata"].count("deleted") && group["metadata"]["deleted"].get<bool>() && local) {
                 store->remove(local.get());
+                groupsLocal.erase(resourceName);
                 continue;
             }
 
@@ -124,6 +136,7 @@ void GoogleContactsWorker::run() {
             if (local == nullptr) {
                 local = make_shared<ContactGroup>(MailUtils::idRandomlyGenerated(), account->id());
                 local->setGoogleResourceName(resourceName);
+                groupsLocal[resourceName] = local;
             }
             local->setName(name);
             local->setBookId(book->id());
@@ -134,11 +147,14 @@ void GoogleContactsWorker::run() {
             // whenever a group changes, we re-sync it's membership list
             if (memberCount > 0) {
                 auto json = PerformJSONRequest(CreateJSONRequest(GOOGLE_PEOPLE_ROOT + resourceName + "?maxMembers=" + to_string(memberCount), "GET", authorization));
+                vector<string> memberResourceNames;
                 for (const auto & memberResourceName : json["memberResourceNames"]) {
-                    auto mrn = memberResourceName.get<string>();
-                    auto c = contactsLocal[mrn];
-                    if (c) {
-                        members.push_back(c->id());
+                    memberResourceNames.push_back(memberResourceName.get<string>());
+                }
+                auto contactsLocal = findContactsByResourceName(memberResourceNames);
+                for (const auto & mrn : memberResourceNames) {
+                    if (contactsLocal.count(mrn)) {
+                        members.push_back(contactsLocal[mrn]->id());
                     } else {
                         logger->warn("Google group references resourceName not found: {}", mrn);
                     }
@@ -149,16 +165,29 @@ void GoogleContactsWorker::run() {
     }));
 }
 
-void GoogleContactsWorker::paginateGoogleCollection(string urlRoot, string authorization, string syncTokenKey, std::function<void(json)> yieldBlock) {
+void GoogleContactsWorker::paginateGoogleCollection(string urlRoot, string authorization, string syncTokenKey, std::function<void(const json &)> yieldBlock) {
     string syncToken = store->getKeyValue(syncTokenKey);
-    
-    string nextPageToken = "";
+
+    // The page token is persisted after each page is applied so an interrupted
+    // sync resumes mid-stream instead of starting over. If we're interrupted
+    // between applying a page and saving the token the page is re-applied,
+    // which is harmless because contacts are matched by resource name.
+    string pageTokenKey = syncTokenKey + "-page";
+    string nextPageToken = store->getKeyValue(pageTokenKey);
     string nextSyncToken = "";
+    bool first = true;
+
+    if (nextPageToken != "") {
+        logger->info("Resuming Google sync of {} from saved page token.", syncTokenKey);
+    }
     
     while (nextPageToken != "END") {
-        // Debounce 2sec on each request because Google has a 90 req. per second
+        // Debounce 2sec between requests because Google has a 90 req. per second
         // limit per user on the contacts API and is fast enough we blow through it.
-        std::this_thread::sleep_for(std::chrono::milliseconds(2000));
+        if (!first) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2000));
+        }
+        first = false;
 
         auto url = urlRoot;
         if (nextPageToken != "") {
@@ -176,6 +205,9 @@ void GoogleContactsWorker::paginateGoogleCollection(string urlRoot, string autho
         } catch (SyncException & ex) {
             if (ex.debuginfo.find("Sync token is expired") != string::npos) {
                 store->saveKeyValue(syncTokenKey, "");
+                store->saveKeyValue(pageTokenKey, "");
+            } else if (ex.debuginfo.find("page token") != string::npos || ex.debuginfo.find("pageToken") != string::npos) {
+                store->saveKeyValue(pageTokenKey, "");
             }
             throw;
         }
@@ -190,7 +222,8 @@ void GoogleContactsWorker::paginateGoogleCollection(string urlRoot, string autho
         }
         
         yieldBlock(json);
-        
+
+        store->saveKeyValue(pageTokenKey, nextPageToken == "END" ? "" : nextPageToken);
     }
 
     if (nextSyncToken != "") {
@@ -284,3 +317,14 @@ void GoogleContactsWorker::applyJSONToContact(shared_ptr<Contact> local, const j
     local->setName(primaryName);
     local->setInfo(conn);
 }
+
+map<string, shared_ptr<Contact>> GoogleContactsWorker::findContactsByResourceName(vector<string> resourceNames) {
+    map<string, shared_ptr<Contact>> results;
+    for (auto chunk : MailUtils::chunksOfVector(resourceNames, 900)) {
+        auto query = Query().equal("accountId", account->id()).equal("grn", chunk);
+        for (auto contact : store->findAll<Contact>(query)) {
+            results[contact->googleResourceName()] = contact;
+        }
+    }
+    return results;
+}
@@ -40,7 +40,7 @@ public:
     GoogleContactsWorker(shared_ptr<Account> account);
 
     void run();
-    void paginateGoogleCollection(string urlRoot, string authorization, string syncTokenKey, std::function<void(json)> yieldBlock);
+    void paginateGoogleCollection(string urlRoot, string authorization, string syncTokenKey, std::function<void(const json &)> yieldBlock);
     
     void upsertContactGroup(shared_ptr<ContactGroup> group);
     void deleteContactGroup(string groupResourceName);
@@ -50,6 +50,7 @@ public:
 
 private:
     void applyJSONToContact(shared_ptr<Contact> local, const json & conn);
+    map<string, shared_ptr<Contact>> findContactsByResourceName(vector<string> resourceNames);
 
 };
 
@@ -0,0 +1,155 @@
+//
+//  LocalTaskQueue.cpp
+//  MailSync
+//
+//  Copyright © 2026 Foundry 376. All rights reserved.
+//
+//  Use of this file is subject to the terms and conditions defined
+//  in 'LICENSE.md', which is part of the Mailspring-Sync package.
+//
+
+#include "LocalTaskQueue.hpp"
+#include "MailStore.hpp"
+#include "Task.hpp"
+#include "TaskProcessor.hpp"
+
+#include <StanfordCPPLib/exceptions.h>
+
+// Tasks that reference more threads / messages than this are run after all the others.
+#define BULK_TASK_THRESHOLD     100
+
+// The stdin reader waits once this many commands are queued.
+#define MAX_QUEUED_COMMANDS     1000
+
+// Tasks that only change specific messages, threads or drafts. These may run before queued
+// bulk tasks they don't overlap with. Tasks that change folders, labels, contacts, etc. never do.
+static const set<string> INDEPENDENT_TASK_TYPES = {
+    "ChangeUnreadTask",
+    "ChangeStarredTask",
+    "ChangeFolderTask",
+    "ChangeLabelsTask",
+    "SyncbackDraftTask",
+    "DestroyDraftTask",
+    "SendDraftTask",
+    "SyncbackMetadataTask",
+};
+
+LocalTaskQueue::LocalTaskQueue(shared_ptr<Account> account, function<void()> onPerformed) :
+    account(account),
+    logger(spdlog::get("logger")),
+    onPerformed(onPerformed)
+{
+}
+
+bool LocalTaskQueue::isQueuedInBulk(Entry & entry) {
+    for (auto & queued : bulk) {
+        for (auto & id : entry.ids) {
+            if (queued.ids.count(id)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void LocalTaskQueue::enqueue(string type, json & packet) {
+    Entry entry{type, packet, {}};
+    size_t objectCount = 0;
+    bool mayRunEarly = type == "cancel-task";
+
+    if (type == "queue-task") {
+        json & data = entry.packet["task"];
+        if (data.count("__cls") && data["__cls"].is_string()) {
+            mayRunEarly = INDEPENDENT_TASK_TYPES.count(data["__cls"].get<string>()) > 0;
+        }
+        for (auto key : {"id", "modelId", "path"}) {
+            if (data.count(key) && data[key].is_string()) {
+                entry.ids.insert(data[key].get<string>());
+            }
+        }
+        for (auto key : {"threadIds", "messageIds"}) {
+            if (data.count(key) && data[key].is_array()) {
+                for (auto & id : data[key]) {
+                    entry.ids.insert(id.get<string>());
+                }
+                objectCount += data[key].size();
+            }
+        }
+        // Folders and labels the task moves messages into or out of, and the thread
+        // of a draft, conflict with tasks that rename / delete them or touch the thread.
+        vector<json> referenced{};
+        for (auto key : {"folder", "draft"}) {
+            if (data.count(key) && data[key].is_object()) {
+                referenced.push_back(data[key]);
+            }
+        }
+        for (auto key : {"labelsToAdd", "labelsToRemove"}) {
+            if (data.count(key) && data[key].is_array()) {
+                referenced.insert(referenced.end(), data[key].begin(), data[key].end());
+            }
+        }
+        for (auto & item : referenced) {
+            for (auto key : {"id", "path", "threadId"}) {
+                if (item.count(key) && item[key].is_string()) {
+                    entry.ids.insert(item[key].get<string>());
+                }
+            }
+        }
+    } else if (type == "cancel-task") {
+        entry.ids.insert(packet["taskId"].get<string>());
+    }
+
+    unique_lock<mutex> lck(mtx);
+    cv.wait(lck, [this]{ return interactive.size() + bulk.size() < MAX_QUEUED_COMMANDS; });
+
+    // The remote halves of tasks run in the order performLocal saved them, so running a
+    // task early reorders its server-side changes too. Only small tasks of the types above
+    // may run before queued bulk tasks, and only if they don't touch the same threads,
+    // messages, folders or labels. Everything else waits its turn behind the bulk tasks.
+    bool waitsForBulk = !mayRunEarly && bulk.size() > 0;
+    if (objectCount > BULK_TASK_THRESHOLD || waitsForBulk || isQueuedInBulk(entry)) {
+        bulk.push_back(std::move(entry));
+    } else {
+        interactive.push_back(std::move(entry));
+    }
+    cv.notify_all();
+}
+
+void LocalTaskQueue::run() {
+    MailStore store;
+    TaskProcessor processor{account, &store, nullptr};
+
+    store.setStreamDelay(5);
+    processor.cleanupTasksAfterLaunch();
+
+    while (true) {
+        Entry entry;
+        {
+            unique_lock<mutex> lck(mtx);
+            cv.wait(lck, [this]{ return !interactive.empty() || !bulk.empty(); });
+            deque<Entry> & source = interactive.empty() ? bulk : interactive;
+            entry = std::move(source.front());
+            source.pop_front();
+            cv.notify_all();
+        }
+
+        AutoreleasePool pool;
+        try {
+            if (entry.type == "queue-task") {
+                entry.packet["task"]["v"] = 0;
+                Task task{entry.packet["task"]};
+                processor.performLocal(&task);
+                onPerformed();
+            }
+
+            if (entry.type == "cancel-task") {
+                // we can't always dequeue a task (if it's started already or potentially even finished).
+                // but if we're deleting a draft we want to dequeue saves, etc.
+                processor.cancel(entry.packet["taskId"].get<string>());
+            }
+        } catch (...) {
+            exceptions::logCurrentExceptionWithStackTrace();
+            abort();
+        }
+    }
+}
@@ -0,0 +1,63 @@
+//
+//  LocalTaskQueue.hpp
+//  MailSync
+//
+//  Copyright © 2026 Foundry 376. All rights reserved.
+//
+//  Use of this file is subject to the terms and conditions defined
+//  in 'LICENSE.md', which is part of the Mailspring-Sync package.
+//
+
+#ifndef LocalTaskQueue_hpp
+#define LocalTaskQueue_hpp
+
+#include <stdio.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+
+#include "json.hpp"
+#include "spdlog/spdlog.h"
+
+#include "Account.hpp"
+
+using namespace nlohmann;
+using namespace std;
+
+// Runs the local part of tasks sent by the client on a dedicated thread, so the stdin
+// reader can keep handling packets while a large task is applied to the database.
+//
+// Small message-level tasks are run before queued bulk tasks, unless they touch the same
+// threads, messages, folders or labels. Cancellations always run after the task they cancel.
+class LocalTaskQueue {
+    struct Entry {
+        string type;
+        json packet;
+        set<string> ids;
+    };
+
+    shared_ptr<Account> account;
+    shared_ptr<spdlog::logger> logger;
+    function<void()> onPerformed;
+
+    mutex mtx;
+    condition_variable cv;
+    deque<Entry> interactive;
+    deque<Entry> bulk;
+
+    bool isQueuedInBulk(Entry & entry);
+
+public:
+    LocalTaskQueue(shared_ptr<Account> account, function<void()> onPerformed);
+
+    // Called from the stdin reader. Blocks if too many commands are waiting.
+    void enqueue(string type, json & packet);
+
+    void run();
+};
+
+#endif /* LocalTaskQueue_hpp */
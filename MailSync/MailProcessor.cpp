@@ -27,6 +27,10 @@
 using namespace std;
 using nlohmann::json;
 
+// Longest body text we index in ThreadSearch. Snippets are a prefix of it.
+#define SEARCH_BODY_TEXT_LENGTH     5000
+#define SNIPPET_LENGTH              400
+
 class CleanHTMLBodyRendererTemplateCallback : public Object, public HTMLRendererTemplateCallback {
     mailcore::String * templateForMainHeader(MessageHeader * header) {
         return MCSTR("");
@@ -357,7 +361,10 @@ void MailProcessor::retrievedMessageBody(Message * message, MessageParser * pars
         bodyRepresentation = text->UTF8Characters();
         bodyIsPlaintext = true;
     } else {
-        String * flattenedHTML = html->flattenHTML();
+        // We only ever index / display the first few thousand characters, so flatten
+        // in one pass and stop parsing as soon as we have enough text. The stored body
+        // is the raw HTML - the client sanitizes it - so there's no need to run Tidy here.
+        String * flattenedHTML = html->flattenHTMLWithMaxLength(SEARCH_BODY_TEXT_LENGTH);
         if (flattenedHTML != NULL) {
             text = flattenedHTML->stripWhitespace();
         } else {
@@ -442,7 +449,7 @@ void MailProcessor::retrievedMessageBody(Message * message, MessageParser * pars
         }
 
         // write the message snippet. This also gives us the database trigger!
-        message->setSnippet(text->substringToIndex(400)->UTF8Characters());
+        message->setSnippet(text->substringToIndex(SNIPPET_LENGTH)->UTF8Characters());
         message->setPlaintext(bodyIsPlaintext);
         message->setBodyForDispatch(bodyRepresentation);
         message->setFiles(files);
@@ -498,18 +505,18 @@ bool MailProcessor::retrievedFileData(File * file, Data * data) {
     wstring_convert<codecvt_utf8<wchar_t>, wchar_t> convert;
     return (data->writeToFile(AS_WIDE_MCSTR(convert.from_bytes(path))) == ErrorNone);
 #else
-    return (data->writeToFile(AS_MCSTR(path)) == ErrorNone);
+    String mcpath(path.c_str());
+    return (data->writeToFile(&mcpath) == ErrorNone);
 #endif
 }
 
 void MailProcessor::unlinkMessagesMatchingQuery(Query & query, int phase)
 {
-    // Note: This method may be called with a Query() returning the entire folder
-    // in case of UIDInvalidity. Loading + saving is super inefficient in this rare case,
-    // but the field is currently both in the JSON and in a separate column. In the future
-    // we may want to make the column the sole source of truth, but it looks like a
-    // complicated change because _data is used for cloning models, etc and inflation
-    // is very abstracted.
+    // Note: Loading + saving is inefficient for large queries, but the field is currently
+    // both in the JSON and in a separate column. In the future we may want to make the
+    // column the sole source of truth, but it looks like a complicated change because
+    // _data is used for cloning models, etc and inflation is very abstracted. UIDInvalidity,
+    // which affects the entire folder, goes through remapMessageUIDsInFolder instead.
     
     logger->info("Unlinking messages {} no longer present in remote range.", query.getSQL());
     
@@ -545,6 +552,78 @@ void MailProcessor::unlinkMessagesMatchingQuery(Query & query, int phase)
     }
 }
 
+// The key identifying a message across a UIDValidity change. On Gmail the X-GM-MSGID
+// is stable. Elsewhere we use the Message-ID header and date, which are stored in
+// their own columns so both sides can be compared in SQL.
+string MailProcessor::uidRemapKeyForMessage(IMAPMessage * mMsg, bool gmail)
+{
+    if (gmail) {
+        return mMsg->gmailMessageID() ? to_string(mMsg->gmailMessageID()) : "";
+    }
+    MessageHeader * header = mMsg->header();
+    if (header->messageID() == nullptr || header->isMessageIDAutoGenerated()) {
+        return "";
+    }
+    time_t date = header->date() == -1 ? header->receivedDate() : header->date();
+    return string(header->messageID()->UTF8Characters()) + " " + to_string((long long)date);
+}
+
+int MailProcessor::remapMessageUIDsInFolder(Folder & folder, map<string, uint32_t> & remoteUIDsByKey, bool gmail, int phase)
+{
+    // After a UIDValidity change, rather than loading and saving every message in the folder
+    // to unlink it and then re-fetching all of their headers, we unlink the folder and assign
+    // new UIDs to messages we can identify with a couple of set-based UPDATEs. remoteUID lives
+    // both in the JSON and in its own column, so both are updated. Messages we can't match
+    // stay unlinked and are picked up by the next sync of the folder.
+    string localKey = gmail ? "Message.gMsgId" : "Message.headerMessageId || ' ' || CAST(Message.date AS INTEGER)";
+    long long unlinkedUID = UINT32_MAX - phase;
+    int remapped = 0;
+
+    logger->info("Remapping UIDs of messages in {} ({} candidates).", folder.path(), remoteUIDsByKey.size());
+
+    {
+        MailStoreTransaction transaction{store, "remapMessageUIDsInFolder"};
+
+        SQLite::Statement unlink(store->db(), "UPDATE Message SET remoteUID = ?, data = json_set(data, '$.remoteUID', ?) WHERE accountId = ? AND remoteFolderId = ? AND remoteUID <= ?");
+        unlink.bind(1, unlinkedUID);
+        unlink.bind(2, unlinkedUID);
+        unlink.bind(3, folder.accountId());
+        unlink.bind(4, folder.id());
+        unlink.bind(5, (long long)(UINT32_MAX - 5));
+        unlink.exec();
+
+        store->db().exec("CREATE TEMP TABLE IF NOT EXISTS UIDRemap (key TEXT PRIMARY KEY, uid INTEGER)");
+        store->db().exec("DELETE FROM UIDRemap");
+
+        SQLite::Statement insert(store->db(), "INSERT INTO UIDRemap (key, uid) VALUES (?, ?)");
+        for (auto & pair : remoteUIDsByKey) {
+            insert.bind(1, pair.first);
+            insert.bind(2, (long long)pair.second);
+            insert.exec();
+            insert.reset();
+        }
+
+        // Keys shared by several local messages are ambiguous, leave those to the regular sync.
+        SQLite::Statement ambiguous(store->db(), "DELETE FROM UIDRemap WHERE key IN (SELECT " + localKey + " FROM Message WHERE accountId = ? AND remoteFolderId = ? AND remoteUID = ? GROUP BY 1 HAVING COUNT(*) > 1)");
+        ambiguous.bind(1, folder.accountId());
+        ambiguous.bind(2, folder.id());
+        ambiguous.bind(3, unlinkedUID);
+        ambiguous.exec();
+
+        SQLite::Statement remap(store->db(), "UPDATE Message SET remoteUID = UIDRemap.uid, data = json_set(Message.data, '$.remoteUID', UIDRemap.uid) FROM UIDRemap WHERE Message.accountId = ? AND Message.remoteFolderId = ? AND Message.remoteUID = ? AND UIDRemap.key = " + localKey);
+        remap.bind(1, folder.accountId());
+        remap.bind(2, folder.id());
+        remap.bind(3, unlinkedUID);
+        remapped = remap.exec();
+
+        store->db().exec("DELETE FROM UIDRemap");
+        transaction.commit();
+    }
+
+    logger->info("-- {} messages remapped.", remapped);
+    return remapped;
+}
+
 void MailProcessor::deleteMessagesStillUnlinkedFromPhase(int phase)
 {
     bool more = true;
@@ -622,7 +701,7 @@ void MailProcessor::appendToThreadSearchContent(Thread * thread, Message * messa
     }
     
     if (bodyToAppendOrNull != nullptr) {
-        body = body + " " + bodyToAppendOrNull->substringToIndex(5000)->UTF8Characters();
+        body = body + " " + bodyToAppendOrNull->substringToIndex(SEARCH_BODY_TEXT_LENGTH)->UTF8Characters();
     }
     
     if (thread->searchRowId()) {
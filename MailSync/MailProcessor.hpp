@@ -44,6 +44,8 @@ public:
     void retrievedMessageBody(Message * message, MessageParser * parser);
     bool retrievedFileData(File * file, Data * data);
     void unlinkMessagesMatchingQuery(Query & query, int phase);
+    string uidRemapKeyForMessage(IMAPMessage * mMsg, bool gmail);
+    int remapMessageUIDsInFolder(Folder & folder, map<string, uint32_t> & remoteUIDsByKey, bool gmail, int phase);
     void deleteMessagesStillUnlinkedFromPhase(int phase);
     
 private:
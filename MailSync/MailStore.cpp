@@ -100,7 +100,7 @@ MailStore::MailStore() :
     SQLite::Statement(_db, "PRAGMA main.synchronous = NORMAL").exec();
 }
 
-static int CURRENT_VERSION = 9;
+static int CURRENT_VERSION = 10;
 static string VACUUM_TIME_KEY = "VACUUM_TIME";
 static time_t VACUUM_INTERVAL = 30 * 24 * 60 * 60; // 30 days
 
@@ -155,6 +155,11 @@ void MailStore::migrate() {
             SQLite::Statement(_db, sql).exec();
         }
     }
+    if (version < 10) {
+        for (string sql : V10_SETUP_QUERIES) {
+            SQLite::Statement(_db, sql).exec();
+        }
+    }
 
     // Update the version flag. Note that we don't want to go from v3 back to v2
     // if the user re-opens an older version of the app.
@@ -263,6 +268,18 @@ map<uint32_t, MessageAttributes> MailStore::fetchMessagesAttributesInRange(Range
     return results;
 }
 
+void MailStore::adjustThreadCounts(map<string, array<int, 2>> & diffs) {
+    if (!_transactionOpen) {
+        _writeThreadCounts(diffs);
+        return;
+    }
+    for (auto & it : diffs) {
+        auto & pending = _transactionThreadCounts[it.first];
+        pending[0] += it.second[0];
+        pending[1] += it.second[1];
+    }
+}
+
 uint32_t MailStore::fetchMessageUIDAtDepth(Folder & folder, uint32_t depth, uint32_t before) {
     assertCorrectThread();
     SQLite::Statement query(this->_db, "SELECT remoteUID FROM Message WHERE accountId = ? AND remoteFolderId = ? AND remoteUID < ? ORDER BY remoteUID DESC LIMIT 1 OFFSET ?");
@@ -326,6 +343,7 @@ void MailStore::rollbackTransaction() {
     _saveUpdateQueries = {};
     _saveInsertQueries = {};
     _removeQueries = {};
+    _transactionThreadCounts = {};
     try {
         _stmtRollbackTransaction.exec();
         _stmtRollbackTransaction.reset();
@@ -350,6 +368,11 @@ void MailStore::unsafeEraseTransactionDeltas() {
 }
 
 void MailStore::commitTransaction() {
+    if (_transactionThreadCounts.size()) {
+        _writeThreadCounts(_transactionThreadCounts);
+        _transactionThreadCounts = {};
+    }
+
     try {
         _stmtCommitTransaction.exec();
         _stmtCommitTransaction.reset();
@@ -378,20 +401,7 @@ void MailStore::save(MailModel * model) {
     auto tableName = model->tableName();
     
     if (model->version() > 1) {
-        if (!_saveUpdateQueries.count(tableName)) {
-            string pairs{""};
-            for (const auto col : model->columnsForQuery()) {
-                if (col == "id") {
-                    continue;
-                }
-                pairs += (col + " = :" + col + ",");
-            }
-            pairs.pop_back();
-            
-            auto stmt = make_shared<SQLite::Statement>(this->_db, "UPDATE " + tableName + " SET " + pairs + " WHERE id = :id");
-            _saveUpdateQueries[tableName] = stmt;
-        }
-        auto query = _saveUpdateQueries[tableName];
+        auto query = _updateQueryFor(model);
         query->reset();
         query->clearBindings();
         model->bindToQuery(query.get());
@@ -429,6 +439,46 @@ void MailStore::save(MailModel * model) {
     _emit(delta);
 }
 
+void MailStore::saveAll(vector<shared_ptr<MailModel>> & models) {
+    assertCorrectThread();
+
+    if (models.size() == 0) {
+        return;
+    }
+
+    // Same as save(), but the deltas for all the models are emitted as one item, which
+    // is much cheaper to build and coalesce when thousands of models change at once.
+    vector<shared_ptr<MailModel>> updated;
+    updated.reserve(models.size());
+
+    for (auto & model : models) {
+        if (model->version() == 0) {
+            save(model.get());
+            continue;
+        }
+        model->incrementVersion();
+        model->beforeSave(this);
+
+        auto query = _updateQueryFor(model.get());
+        query->reset();
+        query->clearBindings();
+        model->bindToQuery(query.get());
+        query->exec();
+
+        model->afterSave(this);
+        updated.push_back(model);
+    }
+
+    if (models[0]->tableName() == "Label") {
+        globalLabelsVersion += 1;
+    }
+
+    if (updated.size()) {
+        DeltaStreamItem delta {DELTA_TYPE_PERSIST, updated};
+        _emit(delta);
+    }
+}
+
 void MailStore::saveFolderStatus(Folder * folder, json & initialStatus) {
     json & changedStatus = folder->localStatus();
     if (changedStatus == initialStatus) {
@@ -473,6 +523,39 @@ void MailStore::remove(MailModel * model) {
     _emit(delta);
 }
 
+shared_ptr<SQLite::Statement> MailStore::_updateQueryFor(MailModel * model) {
+    auto tableName = model->tableName();
+    if (!_saveUpdateQueries.count(tableName)) {
+        string pairs{""};
+        for (const auto col : model->columnsForQuery()) {
+            if (col == "id") {
+                continue;
+            }
+            pairs += (col + " = :" + col + ",");
+        }
+        pairs.pop_back();
+        
+        auto stmt = make_shared<SQLite::Statement>(this->_db, "UPDATE " + tableName + " SET " + pairs + " WHERE id = :id");
+        _saveUpdateQueries[tableName] = stmt;
+    }
+    return _saveUpdateQueries[tableName];
+}
+
+void MailStore::_writeThreadCounts(map<string, array<int, 2>> & diffs) {
+    SQLite::Statement changeCounters(this->_db, "UPDATE ThreadCounts SET unread = unread + ?, total = total + ? WHERE categoryId = ?");
+
+    for (auto & it : diffs) {
+        if (it.second[0] == 0 && it.second[1] == 0) {
+            continue;
+        }
+        changeCounters.bind(1, it.second[0]);
+        changeCounters.bind(2, it.second[1]);
+        changeCounters.bind(3, it.first);
+        changeCounters.exec();
+        changeCounters.reset();
+    }
+}
+
 void MailStore::_emit(DeltaStreamItem & delta) {
     if (_transactionOpen) {
         _transactionDeltas.push_back(delta);
@@ -515,6 +598,23 @@ vector<shared_ptr<MailModel>> MailStore::findAllGeneric(string type, Query query
     assert(false);
 }
 
+vector<shared_ptr<MailModel>> MailStore::findLargeSetGeneric(string type, std::string colname, vector<std::string> & set) {
+    assertCorrectThread();
+    transform(type.begin(), type.end(), type.begin(), ::tolower);
+
+    if (type == "message") {
+        auto results = findLargeSet<Message>(colname, set);
+        return std::vector<std::shared_ptr<MailModel>>(results.begin(), results.end());
+    } else if (type == "thread") {
+        auto results = findLargeSet<Thread>(colname, set);
+        return std::vector<std::shared_ptr<MailModel>>(results.begin(), results.end());
+    } else if (type == "contact") {
+        auto results = findLargeSet<Contact>(colname, set);
+        return std::vector<std::shared_ptr<MailModel>>(results.begin(), results.end());
+    }
+    assert(false);
+}
+
 vector<Metadata> MailStore::findAndDeleteDetachedPluginMetadata(string accountId, string objectId) {
     assertCorrectThread();
     if (!_saveInsertQueries.count("metadata")) {
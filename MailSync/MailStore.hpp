@@ -13,6 +13,7 @@
 #define MailStore_hpp
 
 #include <stdio.h>
+#include <array>
 #include <vector>
 
 #include <MailCore/MailCore.h>
@@ -61,6 +62,7 @@ class MailStore {
     
     bool _transactionOpen;
     vector<DeltaStreamItem> _transactionDeltas;
+    map<string, array<int, 2>> _transactionThreadCounts;
 
     map<string, shared_ptr<SQLite::Statement>> _saveUpdateQueries;
     map<string, shared_ptr<SQLite::Statement>> _saveInsertQueries;
@@ -96,8 +98,21 @@ public:
 
     void save(MailModel * model);
 
+    // Saves many models of the same class and emits their deltas as a single item.
+    void saveAll(vector<shared_ptr<MailModel>> & models);
+
+    template<typename ModelClass>
+    void saveAll(vector<shared_ptr<ModelClass>> & models) {
+        vector<shared_ptr<MailModel>> generic{models.begin(), models.end()};
+        saveAll(generic);
+    }
+
     void saveFolderStatus(Folder * folder, json & initialLocalStatus);
 
+    // Adds {unread, total} to the ThreadCounts of each category. Inside a transaction
+    // the changes are summed and written once when the transaction commits.
+    void adjustThreadCounts(map<string, array<int, 2>> & diffs);
+
     uint32_t fetchMessageUIDAtDepth(Folder & folder, uint32_t depth, uint32_t before = UINT32_MAX);
 
     map<uint32_t, MessageAttributes> fetchMessagesAttributesInRange(mailcore::Range range, Folder & folder);
@@ -117,6 +132,8 @@ public:
     shared_ptr<MailModel> findGeneric(string type, Query query);
     
     vector<shared_ptr<MailModel>> findAllGeneric(string type, Query query);
+
+    vector<shared_ptr<MailModel>> findLargeSetGeneric(string type, std::string colname, vector<std::string> & set);
     
     // Find - Template methods which must be defined in header file
     
@@ -226,6 +243,10 @@ public:
 
 private:
 
+    shared_ptr<SQLite::Statement> _updateQueryFor(MailModel * model);
+
+    void _writeThreadCounts(map<string, array<int, 2>> & diffs);
+
     void _emit(DeltaStreamItem & delta);
 };
 
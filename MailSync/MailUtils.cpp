@@ -19,6 +19,10 @@
 #include "Account.hpp"
 #include "Query.hpp"
 
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
 #if defined(_MSC_VER)
 #include <direct.h>
 #include <codecvt>
@@ -29,6 +33,17 @@ using namespace std;
 using namespace mailcore;
 using namespace nlohmann;
 
+#define INTERNED_STRING_CAPACITY 512
+
+typedef list<pair<string, String *>> InternedStringList;
+
+static std::mutex internedStringsMtx;
+static InternedStringList internedStrings;
+static unordered_map<string, InternedStringList::iterator> internedStringsIndex;
+static uint64_t internedStringsHits = 0;
+static uint64_t internedStringsMisses = 0;
+static uint64_t internedStringsEvictions = 0;
+
 static vector<string> unworthyPrefixes = {
     "noreply",
     "no-reply",
@@ -230,9 +245,9 @@ json MailUtils::contactJSONFromAddress(Address * addr) {
 
 Address * MailUtils::addressFromContactJSON(json & j) {
     if (j["name"].is_string()) {
-        return Address::addressWithDisplayName(AS_MCSTR(j["name"].get<string>()), AS_MCSTR(j["email"].get<string>()));
+        return Address::addressWithDisplayName(AS_TRANSIENT_MCSTR(j["name"].get<string>()), AS_TRANSIENT_MCSTR(j["email"].get<string>()));
     }
-    return Address::addressWithMailbox(AS_MCSTR(j["email"].get<string>()));
+    return Address::addressWithMailbox(AS_TRANSIENT_MCSTR(j["email"].get<string>()));
 }
 
 string MailUtils::contactKeyForEmail(string email) {
@@ -447,6 +462,21 @@ string MailUtils::pathForFile(string root, File * file, bool create) {
     return path;
 }
 
+string MailUtils::pathForTemporaryFile(string name) {
+    string root = MailUtils::getEnvUTF8("CONFIG_DIR_PATH") + FS_PATH_SEP + "tmp";
+    if (!create_directory(root)) { return ""; }
+    return root + FS_PATH_SEP + name;
+}
+
+bool MailUtils::removeFile(string path) {
+#if defined(_WIN32)
+    wstring_convert<codecvt_utf8<wchar_t>, wchar_t> convert;
+    return _wremove(convert.from_bytes(path).c_str()) == 0;
+#else
+    return remove(path.c_str()) == 0;
+#endif
+}
+
 shared_ptr<Label> MailUtils::labelForXGMLabelName(string mlname, vector<shared_ptr<Label>> allLabels) {
     for (const auto & label : allLabels) {
         if (label->path() == mlname) {
@@ -778,17 +808,64 @@ class MailcoreSPDLogger : public ConnectionLogger {
     }
 };
 
+String * MailUtils::internedString(const string & value) {
+    String * result = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(internedStringsMtx);
+        auto it = internedStringsIndex.find(value);
+        if (it != internedStringsIndex.end()) {
+            internedStrings.splice(internedStrings.begin(), internedStrings, it->second);
+            result = it->second->second;
+            internedStringsHits++;
+        } else {
+            result = new String(value.c_str());
+            internedStrings.emplace_front(value, result);
+            internedStringsIndex[value] = internedStrings.begin();
+            internedStringsMisses++;
+
+            if (internedStrings.size() > INTERNED_STRING_CAPACITY) {
+                auto & oldest = internedStrings.back();
+                internedStringsIndex.erase(oldest.first);
+                oldest.second->release();
+                internedStrings.pop_back();
+                internedStringsEvictions++;
+            }
+        }
+        // retain before unlocking so a concurrent eviction can't free it
+        result->retain();
+    }
+    result->autorelease();
+    return result;
+}
+
+json MailUtils::internedStringStats() {
+    std::lock_guard<std::mutex> lock(internedStringsMtx);
+    return {
+        {"size", internedStrings.size()},
+        {"capacity", INTERNED_STRING_CAPACITY},
+        {"hits", internedStringsHits},
+        {"misses", internedStringsMisses},
+        {"evictions", internedStringsEvictions},
+    };
+}
+
 void MailUtils::configureSessionForAccount(IMAPSession &session, shared_ptr<Account> account) {
     if (account->refreshToken() != "") {
         XOAuth2Parts parts = SharedXOAuth2TokenManager()->partsForAccount(account);
-        session.setUsername(AS_MCSTR(parts.username));
-        session.setOAuth2Token(AS_MCSTR(parts.accessToken));
+        // The session copies these, so stack strings avoid interning credentials
+        String username(parts.username.c_str());
+        String token(parts.accessToken.c_str());
+        session.setUsername(&username);
+        session.setOAuth2Token(&token);
         session.setAuthType(AuthTypeXOAuth2);
     } else {
-        session.setUsername(AS_MCSTR(account->IMAPUsername()));
-        session.setPassword(AS_MCSTR(account->IMAPPassword()));
+        String username(account->IMAPUsername().c_str());
+        String password(account->IMAPPassword().c_str());
+        session.setUsername(&username);
+        session.setPassword(&password);
     }
-    session.setHostname(AS_MCSTR(account->IMAPHost()));
+    String hostname(account->IMAPHost().c_str());
+    session.setHostname(&hostname);
     session.setPort(account->IMAPPort());
     if (account->IMAPSecurity() == "SSL / TLS") {
         session.setConnectionType(ConnectionType::ConnectionTypeTLS);
@@ -818,14 +895,20 @@ void MailUtils::configureSessionForAccount(IMAPSession &session, shared_ptr<Acco
 void MailUtils::configureSessionForAccount(SMTPSession & session, shared_ptr<Account> account) {
     if (account->refreshToken() != "") {
         XOAuth2Parts parts = SharedXOAuth2TokenManager()->partsForAccount(account);
-        session.setUsername(AS_MCSTR(parts.username));
-        session.setOAuth2Token(AS_MCSTR(parts.accessToken));
+        // The session copies these, so stack strings avoid interning credentials
+        String username(parts.username.c_str());
+        String token(parts.accessToken.c_str());
+        session.setUsername(&username);
+        session.setOAuth2Token(&token);
         session.setAuthType(AuthTypeXOAuth2);
     } else {
-        session.setUsername(AS_MCSTR(account->SMTPUsername()));
-        session.setPassword(AS_MCSTR(account->SMTPPassword()));
+        String username(account->SMTPUsername().c_str());
+        String password(account->SMTPPassword().c_str());
+        session.setUsername(&username);
+        session.setPassword(&password);
     }
-    session.setHostname(AS_MCSTR(account->SMTPHost()));
+    String hostname(account->SMTPHost().c_str());
+    session.setHostname(&hostname);
     session.setPort(account->SMTPPort());
     if (account->SMTPSecurity() == "SSL / TLS") {
         session.setConnectionType(ConnectionType::ConnectionTypeTLS);
@@ -57,6 +57,8 @@ public:
     static vector<Query> queriesForUIDRangesInIndexSet(string remoteFolderId, IndexSet * set);
 
     static string pathForFile(string root, File * file, bool create);
+    static string pathForTemporaryFile(string name);
+    static bool removeFile(string path);
 
     static string namespacePrefixOrBlank(IMAPSession * session);
 
@@ -87,6 +89,12 @@ public:
     static void configureSessionForAccount(IMAPSession & session, shared_ptr<Account> account);
     static void configureSessionForAccount(SMTPSession & session, shared_ptr<Account> account);
     
+    // Process-wide LRU of mailcore Strings for values that repeat for the life of
+    // the process (folder paths, label names). The result is autoreleased, so an
+    // AutoreleasePool must be in scope. Use AS_TRANSIENT_MCSTR for anything else.
+    static String * internedString(const string & value);
+    static json internedStringStats();
+
     static IMAPMessagesRequestKind messagesRequestKindFor(IndexSet * capabilities, bool heavyOrNeedToComputeIDs);
 
     static void sleepWorkerUntilWakeOrSec(int sec);
@@ -19,6 +19,7 @@
 #include "NetworkRequestUtils.hpp"
 #include "exceptions.h"
 
+#include <set>
 #include <string>
 #include <curl/curl.h>
 
@@ -32,6 +33,14 @@ static size_t _onDeltaData(void *contents, size_t length, size_t nmemb, void *us
     return real_size;
 }
 
+static int _onDeltaProgress(void *userp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow) {
+    // libcurl calls this roughly once per second even when the stream is idle,
+    // which lets us apply a partial batch without waiting for more data to arrive.
+    MetadataWorker * worker = (MetadataWorker *)userp;
+    worker->flushPendingDeltas(false);
+    return 0;
+}
+
 
 MetadataWorker::MetadataWorker(shared_ptr<Account> account) :
     store(new MailStore()),
@@ -89,9 +98,11 @@ void MetadataWorker::run() {
 bool MetadataWorker::fetchMetadata(int page) {
     int pageSize = 500;
     const json & metadata = PerformIdentityRequest("/metadata/" + account->id() + "?limit=" + to_string(pageSize) + "&offset=" + to_string(pageSize * page));
+    vector<Metadata> items;
     for (const auto & metadatum : metadata) {
-        applyMetadataJSON(metadatum);
+        items.push_back(MetadataFromJSON(metadatum));
     }
+    applyMetadata(items);
     return metadata.size() == pageSize;
 }
 
@@ -124,6 +135,9 @@ void MetadataWorker::fetchDeltasBlocking() {
     CURL * curl_handle = CreateIdentityRequest("/deltas/" + account->id() + "/streaming?p=" + platform + "&ih=" + aEscaped + "&cursor=" + deltasCursor);
     curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, _onDeltaData);
     curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void *)this);
+    curl_easy_setopt(curl_handle, CURLOPT_XFERINFOFUNCTION, _onDeltaProgress);
+    curl_easy_setopt(curl_handle, CURLOPT_XFERINFODATA, (void *)this);
+    curl_easy_setopt(curl_handle, CURLOPT_NOPROGRESS, 0L);
 
     // Force HTTP/1.1 for the streaming connection. HTTP/2 multiplexing provides no
     // benefit for a single long-lived stream, and HTTP/2 framing errors (CURLE_HTTP2,
@@ -142,6 +156,9 @@ void MetadataWorker::fetchDeltasBlocking() {
     // https://curl.haxx.se/libcurl/c/multi-single.html
     logger->info("Metadata delta stream starting...");
     CURLcode res = curl_easy_perform(curl_handle);
+    flushPendingDeltas(true);
+    deltasBuffer.reset();
+
     if (res == CURLE_OPERATION_TIMEDOUT) {
         logger->info("Metadata delta stream timed out.");
     } else {
@@ -158,70 +175,121 @@ void MetadataWorker::setDeltaCursor(string cursor) {
 }
 
 void MetadataWorker::onDeltaData(void * contents, size_t bytes) {
-    _onAppendToString(contents, bytes, 1, &deltasBuffer);
-    
-    bool matched = true;
-    while (matched) {
-        size_t pos = deltasBuffer.find("\n");
-        if (pos == string::npos) {
-            matched = false;
-            break;
+    deltasBuffer.append((const char *)contents, bytes, [&](const char * line, size_t length) {
+        if (length <= 1) { // ignore heartbeat newlines
+            return;
         }
-
-        if (pos > 1) { // ignore heartbeat newlines
-            string delta { deltasBuffer.substr(0, pos) };
-            
-            try {
-                json deltaJSON = json::parse(delta);
-                onDelta(deltaJSON);
-            } catch (json::exception & ex) {
-                json resp = {{"error", ex.what()}};
-                this->logger->error("Received invalid JSON in server delta stream: {}", delta);
-            }
+        try {
+            json deltaJSON = json::parse(line, line + length);
+            onDelta(deltaJSON);
+        } catch (json::exception & ex) {
+            this->logger->error("Received invalid JSON in server delta stream: {}", string(line, length));
         }
+    });
 
-        deltasBuffer = deltasBuffer.substr(pos + 1, deltasBuffer.length() - pos);
-    }
+    flushPendingDeltas(false);
 }
 
 void MetadataWorker::onDelta(const json & delta) {
     string klass = delta["object"].get<string>() ;
     if (klass == "metadata") {
-        applyMetadataJSON(delta["attributes"]);
-        setDeltaCursor(delta["cursor"]);
+        if (pendingMetadata.empty()) {
+            pendingSince = chrono::steady_clock::now();
+        }
+        pendingMetadata.push_back(MetadataFromJSON(delta["attributes"]));
+        if (delta["cursor"].is_number()) {
+            pendingCursor = to_string(delta["cursor"].get<uint64_t>());
+        } else {
+            pendingCursor = delta["cursor"].get<string>();
+        }
+        if (pendingMetadata.size() >= METADATA_BATCH_MAX_ITEMS) {
+            flushPendingDeltas(true);
+        }
     } else {
         logger->info("Received delta of unexpected type `{}`", klass);
     }
 }
 
-void MetadataWorker::applyMetadataJSON(const json & metadataJSON) {
-    // find the associated object
-    auto m = MetadataFromJSON(metadataJSON);
-    {
-        MailStoreTransaction transaction{store, "applyMetadataJSON"};
+void MetadataWorker::flushPendingDeltas(bool force) {
+    if (pendingMetadata.empty()) {
+        return;
+    }
+    if (!force) {
+        auto waitedMs = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - pendingSince).count();
+        if (waitedMs < METADATA_BATCH_MAX_DELAY_MS) {
+            return;
+        }
+    }
+
+    vector<Metadata> batch;
+    batch.swap(pendingMetadata);
+    string cursor = pendingCursor;
+    pendingCursor = "";
+    applyMetadata(batch, cursor);
+}
+
+void MetadataWorker::applyMetadata(vector<Metadata> & items, string cursor) {
+    if (items.empty()) {
+        return;
+    }
 
-        auto model = store->findGeneric(m.objectType, Query().equal("id", m.objectId).equal("accountId", m.accountId));
+    MailStoreTransaction transaction{store, "applyMetadata"};
+
+    // Resolve all of the target models up front with one query per object type
+    // rather than one lookup per metadata item.
+    map<string, vector<string>> idsByType;
+    for (auto & m : items) {
+        idsByType[m.objectType].push_back(m.objectId);
+    }
+    map<string, map<string, shared_ptr<MailModel>>> modelsByType;
+    for (auto & pair : idsByType) {
+        auto & models = modelsByType[pair.first];
+        for (auto & model : store->findLargeSetGeneric(pair.first, "id", pair.second)) {
+            models[model->id()] = model;
+        }
+    }
 
-        logger->info("Received metadata V{} for ({} - {})", m.version, m.objectType, m.objectId);
+    // Apply the metadata in order. A single model may receive several versions
+    // in one batch, so we only save each changed model once at the end.
+    vector<shared_ptr<MailModel>> changed;
+    set<MailModel *> changedSet;
+    int ignored = 0;
+    int detached = 0;
 
-        if (model) {
+    for (auto & m : items) {
+        auto & models = modelsByType[m.objectType];
+        auto it = models.find(m.objectId);
+
+        if (it != models.end() && it->second->accountId() == m.accountId) {
             // attach the metadata to the object. Returns false if the model
             // already has a >= version of the metadata.
-            if (model->upsertMetadata(m.pluginId, m.value, m.version) > 0) {
-                logger->info(" -- Saved on to local model.");
-                store->save(model.get());
+            if (it->second->upsertMetadata(m.pluginId, m.value, m.version) > 0) {
+                if (!changedSet.count(it->second.get())) {
+                    changedSet.insert(it->second.get());
+                    changed.push_back(it->second);
+                }
             } else {
-                logger->info(" -- Ignored. Local model has >= version.");
+                ignored++;
             }
         } else {
             // save to waiting table - when mailsync saves this model, it will attach
             // and remove the metadata if it's available
-            logger->info(" -- Local model is not present. Saving to waiting table.");
             store->saveDetachedPluginMetadata(m);
+            detached++;
         }
-        
-        transaction.commit();
     }
-}
 
+    for (auto & model : changed) {
+        store->save(model.get());
+    }
+
+    // Persist the cursor in the same transaction so it never gets ahead of
+    // (or behind) the metadata we've actually written.
+    if (cursor != "") {
+        setDeltaCursor(cursor);
+    }
+
+    transaction.commit();
 
+    logger->info("Applied {} metadata items: {} models saved, {} ignored (local model has >= version), {} saved to waiting table.", items.size(), changed.size(), ignored, detached);
+}
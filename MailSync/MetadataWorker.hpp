@@ -15,9 +15,11 @@
 #include "Account.hpp"
 #include "Identity.hpp"
 #include "MailStore.hpp"
+#include "NetworkRequestUtils.hpp"
 
 #include <stdio.h>
 
+#include <chrono>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -26,15 +28,24 @@
 
 using namespace std;
 
+// Deltas from the streaming connection are applied in small batches so a large
+// backlog (eg: after a long period offline) isn't written one transaction at a time.
+#define METADATA_BATCH_MAX_ITEMS    250
+#define METADATA_BATCH_MAX_DELAY_MS 500
+
 class MetadataWorker {
     MailStore * store;
     shared_ptr<spdlog::logger> logger;
     shared_ptr<Account> account;
     
-    string deltasBuffer;
+    StreamingLineBuffer deltasBuffer;
     string deltasCursor;
     int backoffStep;
 
+    vector<Metadata> pendingMetadata;
+    string pendingCursor;
+    chrono::steady_clock::time_point pendingSince;
+
 public:
     MetadataWorker(shared_ptr<Account> account);
     
@@ -48,8 +59,9 @@ public:
 
     void onDeltaData(void * contents, size_t bytes);
     void onDelta(const json & delta);
+    void flushPendingDeltas(bool force);
 
-    void applyMetadataJSON(const json & metadata);
+    void applyMetadata(vector<Metadata> & metadata, string cursor = "");
 };
 
 #endif /* MetadataWorker_hpp */
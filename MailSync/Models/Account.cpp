@@ -125,6 +125,22 @@ bool Account::isICloud() {
     return IMAPHost().find("imap.mail.me.com") != string::npos;
 }
 
+int Account::bodySyncMaxAgeDays() {
+    json & s = _data["settings"];
+    if (s.count("body_sync_max_age_days") && s["body_sync_max_age_days"].is_number() && s["body_sync_max_age_days"].get<int>() > 0) {
+        return s["body_sync_max_age_days"].get<int>();
+    }
+    return 90;
+}
+
+long long Account::bodySyncByteBudget() {
+    json & s = _data["settings"];
+    if (s.count("body_sync_byte_budget") && s["body_sync_byte_budget"].is_number() && s["body_sync_byte_budget"].get<long long>() > 0) {
+        return s["body_sync_byte_budget"].get<long long>();
+    }
+    return 32 * 1024 * 1024;
+}
+
 unsigned int Account::SMTPPort() {
     json & val = _data["settings"]["smtp_port"];
     return val.is_string() ? stoi(val.get<string>()) : val.get<unsigned int>();
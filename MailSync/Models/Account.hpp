@@ -51,6 +51,9 @@ public:
 
     bool isICloud();
 
+    int bodySyncMaxAgeDays();
+    long long bodySyncByteBudget();
+
     unsigned int SMTPPort();
     string SMTPHost();
     string SMTPUsername();
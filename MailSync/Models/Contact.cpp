@@ -157,7 +157,7 @@ void Contact::mutateCardInInfo(function<void(shared_ptr<VCard>)> yieldBlock) {
 }
 
 vector<string> Contact::columnsForQuery() {
-    return vector<string>{"id", "data", "accountId", "version", "refs", "email", "hidden", "source", "etag", "bookId" };
+    return vector<string>{"id", "data", "accountId", "version", "refs", "email", "hidden", "source", "etag", "bookId", "grn" };
 }
 
 void Contact::bindToQuery(SQLite::Statement * query) {
@@ -168,6 +168,11 @@ void Contact::bindToQuery(SQLite::Statement * query) {
     query->bind(":source", source());
     query->bind(":etag", etag());
     query->bind(":bookId", bookId());
+    if (googleResourceName() != "") {
+        query->bind(":grn", googleResourceName());
+    } else {
+        query->bind(":grn");
+    }
 }
 
 
@@ -353,26 +353,48 @@ void Thread::afterSave(MailStore * store) {
     double _lmst = (double)lastMessageSentTimestamp();
     map<string, bool> categoryIds = captureCategoryIDs();
 
-    // update the ThreadCategory join table to include our folder and labels
-    // note this is pretty expensive, so we avoid it if relevant attributes
-    // have not changed since the model was loaded.
-    if (_initialCategoryIds != categoryIds || _initialLMRT != _lmrt || _initialLMST != _lmst) {
+    // update the ThreadCategory join table to include our folder and labels. Only the
+    // rows that changed are touched: removed categories are deleted, added ones inserted,
+    // and the remaining rows are updated in place if their sort / filter columns changed.
+    bool sharedColumnsChanged = _initialLMRT != _lmrt || _initialLMST != _lmst || _initialInAllMail != _inAllMail;
+
+    if (_initialCategoryIds != categoryIds || sharedColumnsChanged) {
         string _id = id();
-        SQLite::Statement removeFolders(store->db(), "DELETE FROM ThreadCategory WHERE id = ?");
-        removeFolders.bind(1, id());
-        removeFolders.exec();
-
-        if (categoryIds.size() > 0) {
-            SQLite::Statement insertFolders(store->db(), "INSERT INTO ThreadCategory (id, value, inAllMail, unread, lastMessageReceivedTimestamp, lastMessageSentTimestamp) VALUES (?,?,?,?,?,?)");
-            for (auto& it : categoryIds) {
-                insertFolders.bind(1, _id);
-                insertFolders.bind(2, it.first);
-                insertFolders.bind(3, _inAllMail);
-                insertFolders.bind(4, it.second);
-                insertFolders.bind(5, _lmrt);
-                insertFolders.bind(6, _lmst);
-                insertFolders.exec();
-                insertFolders.reset();
+
+        for (auto& it : _initialCategoryIds) {
+            if (categoryIds.count(it.first)) {
+                continue;
+            }
+            SQLite::Statement removeCategory(store->db(), "DELETE FROM ThreadCategory WHERE id = ? AND value = ?");
+            removeCategory.bind(1, _id);
+            removeCategory.bind(2, it.first);
+            removeCategory.exec();
+        }
+
+        for (auto& it : categoryIds) {
+            auto initial = _initialCategoryIds.find(it.first);
+            bool needsInsert = initial == _initialCategoryIds.end();
+
+            if (!needsInsert && (sharedColumnsChanged || initial->second != it.second)) {
+                SQLite::Statement updateCategory(store->db(), "UPDATE ThreadCategory SET inAllMail = ?, unread = ?, lastMessageReceivedTimestamp = ?, lastMessageSentTimestamp = ? WHERE id = ? AND value = ?");
+                updateCategory.bind(1, _inAllMail);
+                updateCategory.bind(2, it.second);
+                updateCategory.bind(3, _lmrt);
+                updateCategory.bind(4, _lmst);
+                updateCategory.bind(5, _id);
+                updateCategory.bind(6, it.first);
+                // if the row is missing for some reason, fall back to inserting it
+                needsInsert = updateCategory.exec() == 0;
+            }
+            if (needsInsert) {
+                SQLite::Statement insertCategory(store->db(), "INSERT OR REPLACE INTO ThreadCategory (id, value, inAllMail, unread, lastMessageReceivedTimestamp, lastMessageSentTimestamp) VALUES (?,?,?,?,?,?)");
+                insertCategory.bind(1, _id);
+                insertCategory.bind(2, it.first);
+                insertCategory.bind(3, _inAllMail);
+                insertCategory.bind(4, it.second);
+                insertCategory.bind(5, _lmrt);
+                insertCategory.bind(6, _lmst);
+                insertCategory.exec();
             }
         }
     }
@@ -392,18 +414,7 @@ void Thread::afterSave(MailStore * store) {
                 diffs[it.first] = {it.second, 1};
             }
         }
-        SQLite::Statement changeCounters(store->db(), "UPDATE ThreadCounts SET unread = unread + ?, total = total + ? WHERE categoryId = ?");
-
-        for (auto& it : diffs) {
-            if (it.second[0] == 0 && it.second[1] == 0) {
-                continue;
-            }
-            changeCounters.bind(1, it.second[0]);
-            changeCounters.bind(2, it.second[1]);
-            changeCounters.bind(3, it.first);
-            changeCounters.exec();
-            changeCounters.reset();
-        }
+        store->adjustThreadCounts(diffs);
 
         // update the thread search table if we're indexed
         if (searchRowId()) {
@@ -413,6 +424,10 @@ void Thread::afterSave(MailStore * store) {
             update.exec();
         }
     }
+
+    // the database now reflects our state, so further saves of this object
+    // should only apply the changes made after this point.
+    captureInitialState();
 }
 
 void Thread::afterRemove(MailStore * store) {
@@ -423,6 +438,11 @@ void Thread::afterRemove(MailStore * store) {
     // this will remove everything.
     afterSave(store);
 
+    // afterSave only removes the rows it knows about - make sure none are left behind.
+    SQLite::Statement removeCategories(store->db(), "DELETE FROM ThreadCategory WHERE id = ?");
+    removeCategories.bind(1, id());
+    removeCategories.exec();
+
     // Delete search entry
     if (searchRowId()) {
         SQLite::Statement update(store->db(), "DELETE FROM ThreadSearch WHERE rowid = ?");
@@ -448,6 +468,7 @@ map<string, bool> Thread::captureCategoryIDs() {
 void Thread::captureInitialState() {
     _initialLMST = lastMessageSentTimestamp();
     _initialLMRT = lastMessageReceivedTimestamp();
+    _initialInAllMail = inAllMail();
     _initialCategoryIds = captureCategoryIDs();
 }
 
@@ -33,6 +33,7 @@ class Thread : public MailModel {
     
     time_t _initialLMST;
     time_t _initialLMRT;
+    bool _initialInAllMail;
     map<string, bool> _initialCategoryIds;
     
 public:
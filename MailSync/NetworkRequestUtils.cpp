@@ -56,6 +56,45 @@ size_t _onAppendToString(void *contents, size_t length, size_t nmemb, void *user
     return real_size;
 }
 
+StreamingLineBuffer::StreamingLineBuffer() : _readOffset(0), _scanOffset(0) {
+}
+
+void StreamingLineBuffer::append(const char * bytes, size_t length, const function<void(const char * line, size_t length)> & onLine) {
+    // Discard consumed bytes before growing the buffer. We only shift the trailing
+    // partial line, and only once it's cheaper than continuing to grow.
+    if (_readOffset > 0 && _readOffset >= _buffer.size() / 2) {
+        _buffer.erase(0, _readOffset);
+        _scanOffset -= _readOffset;
+        _readOffset = 0;
+    }
+    _buffer.append(bytes, length);
+
+    // memchr is vectorized by the C library, and we never re-scan bytes
+    // that were already searched on a previous call.
+    while (_scanOffset < _buffer.size()) {
+        const char * start = _buffer.data();
+        const char * newline = (const char *)memchr(start + _scanOffset, '\n', _buffer.size() - _scanOffset);
+        if (newline == nullptr) {
+            _scanOffset = _buffer.size();
+            break;
+        }
+        size_t lineStart = _readOffset;
+        size_t lineEnd = newline - start;
+        _readOffset = _scanOffset = lineEnd + 1;
+        onLine(start + lineStart, lineEnd - lineStart);
+    }
+
+    if (_readOffset == _buffer.size()) {
+        reset();
+    }
+}
+
+void StreamingLineBuffer::reset() {
+    _buffer.clear();
+    _readOffset = 0;
+    _scanOffset = 0;
+}
+
 const json MakeOAuthRefreshRequest(string provider, string clientId, string refreshToken) {
     CURL * curl_handle = curl_easy_init();
     const char * url =
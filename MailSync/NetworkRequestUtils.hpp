@@ -14,6 +14,8 @@
 
 #include <curl/curl.h>
 #include <stdio.h>
+#include <functional>
+#include <string>
 #include "json.hpp"
 
 class Account;
@@ -23,6 +25,24 @@ using namespace std;
 
 size_t _onAppendToString(void *contents, size_t length, size_t nmemb, void *userp);
 
+/**
+ Splits a streaming HTTP response into newline-delimited records. Bytes are
+ appended to a single buffer and consumed by advancing a read offset, so a large
+ backlog arriving in one read is split in linear time. Lines are handed to the
+ callback as pointers into the buffer and are only valid during the callback.
+ */
+class StreamingLineBuffer {
+    string _buffer;
+    size_t _readOffset;
+    size_t _scanOffset;
+
+public:
+    StreamingLineBuffer();
+
+    void append(const char * bytes, size_t length, const function<void(const char * line, size_t length)> & onLine);
+    void reset();
+};
+
 // Helper to cleanup curl handle and associated header list stored in CURLOPT_PRIVATE
 void CleanupCurlRequest(CURL * curl_handle);
 
@@ -20,6 +20,26 @@ void IMAPProgress::itemsProgress(IMAPSession * session, unsigned int current, un
     //        cout << "Progress on Item: " << current << "\n";
 }
 
+IMAPMessageStream::IMAPMessageStream(std::function<void(IMAPMessage *)> fn) : fn(fn), failure(nullptr) {
+}
+
+void IMAPMessageStream::fetchedMessage(IMAPSession * session, IMAPMessage * message) {
+    if (failure) {
+        return;
+    }
+    try {
+        fn(message);
+    } catch (...) {
+        failure = std::current_exception();
+    }
+}
+
+void IMAPMessageStream::rethrowIfFailed() {
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
 void SMTPProgress::bodyProgress(IMAPSession * session, unsigned int current, unsigned int maximum) {
     //        cout << "Progress: " << current << "\n";
 }
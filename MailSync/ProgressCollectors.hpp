@@ -13,6 +13,8 @@
 #define ProgressCollectors_hpp
 
 #include <stdio.h>
+#include <functional>
+#include <exception>
 #include <MailCore/MailCore.h>
 
 using namespace mailcore;
@@ -23,6 +25,19 @@ public:
     void itemsProgress(IMAPSession * session, unsigned int current, unsigned int maximum);
 };
 
+// Adapts a lambda to IMAPSession::fetchMessagesByUIDStreaming. Exceptions can't
+// unwind through libetpan, so the first one is captured, the remaining messages
+// are skipped and rethrowIfFailed() raises it once the fetch has returned.
+class IMAPMessageStream : public IMAPMessagesStreamCallback {
+    std::function<void(IMAPMessage *)> fn;
+    std::exception_ptr failure;
+
+public:
+    IMAPMessageStream(std::function<void(IMAPMessage *)> fn);
+    void fetchedMessage(IMAPSession * session, IMAPMessage * message);
+    void rethrowIfFailed();
+};
+
 class SMTPProgress : public SMTPProgressCallback {
 public:
     
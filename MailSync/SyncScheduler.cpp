@@ -0,0 +1,156 @@
+//
+//  SyncScheduler.cpp
+//  MailSync
+//
+//  Copyright © 2026 Foundry 376. All rights reserved.
+//
+//  Use of this file is subject to the terms and conditions defined
+//  in 'LICENSE.md', which is part of the Mailspring-Sync package.
+//
+
+#include "SyncScheduler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#define MIN_SYNC_INTERVAL           30
+#define MAX_SYNC_INTERVAL           60 * 60
+#define FOCUSED_SYNC_INTERVAL       15
+#define FOCUS_DURATION              60 * 10
+#define HOT_FOLDER_WINDOW           60 * 60
+#define COLD_FOLDER_WINDOW          60 * 60 * 24 * 7
+#define CHANGE_RATE_HALF_LIFE       60 * 60 * 6
+
+// Folders without CONDSTORE / QRESYNC only notice deletions and flag changes below the
+// top few hundred messages in a deep scan, so those always run at least this often.
+#define MAX_DEEP_SCAN_INTERVAL      60 * 10
+
+// Sleep at most this long between passes. Every pass starts with a bulk
+// STATUS of all folders, which is how we notice changes in folders we
+// aren't scanning.
+#define MAX_SLEEP_INTERVAL          120
+
+void SyncScheduler::focusFolders(vector<string> & folderIds) {
+    lock_guard<mutex> lock(mtx);
+    time_t until = time(0) + FOCUS_DURATION;
+    for (auto & id : folderIds) {
+        focusedUntil[id] = until;
+    }
+}
+
+bool SyncScheduler::observeStatus(Folder & folder, IMAPFolderStatus & status) {
+    lock_guard<mutex> lock(mtx);
+    FolderState & state = states[folder.id()];
+    time_t now = time(0);
+
+    bool changed = state.lastObservation == 0 ||
+        state.uidNext != status.uidNext() ||
+        state.highestModSeq != status.highestModSeqValue() ||
+        state.messageCount != status.messageCount();
+
+    // The change rate decays by half every CHANGE_RATE_HALF_LIFE, so it roughly
+    // counts the passes that saw a change over the last few hours.
+    if (state.firstObservation == 0) {
+        state.firstObservation = now;
+    } else {
+        state.changeRate *= pow(0.5, (double)(now - state.lastObservation) / CHANGE_RATE_HALF_LIFE);
+        if (changed) {
+            state.changeRate += 1;
+            state.lastChange = now;
+        }
+    }
+    state.lastObservation = now;
+    state.uidNext = status.uidNext();
+    state.highestModSeq = status.highestModSeqValue();
+    state.messageCount = status.messageCount();
+    return changed;
+}
+
+int SyncScheduler::intervalFor(Folder & folder, FolderState & state, time_t now) {
+    if (focusedUntil.count(folder.id()) && focusedUntil[folder.id()] > now) {
+        return FOCUSED_SYNC_INTERVAL;
+    }
+
+    string role = folder.role();
+    double interval = (role == "inbox" || role == "sent" || role == "drafts") ? 120 : 600;
+
+    // Recency of change: a folder that changed in the last hour is likely to change again
+    // soon, one that hasn't changed in a week can wait.
+    if (state.lastChange != 0 && now - state.lastChange < HOT_FOLDER_WINDOW) {
+        interval = min(interval, 60.0);
+    } else if (now - max(state.lastChange, state.firstObservation) > COLD_FOLDER_WINDOW) {
+        // only folders we've watched for a full window without a change count as cold
+        interval *= 3;
+    }
+
+    // Large folders are expensive to scan.
+    if (state.messageCount > 100000) {
+        interval *= 4;
+    } else if (state.messageCount > 10000) {
+        interval *= 2;
+    }
+
+    interval /= (1 + state.changeRate);
+    return (int)max((double)MIN_SYNC_INTERVAL, min((double)MAX_SYNC_INTERVAL, interval));
+}
+
+bool SyncScheduler::isDue(Folder & folder) {
+    lock_guard<mutex> lock(mtx);
+    FolderState & state = states[folder.id()];
+    time_t now = time(0);
+    return now - state.lastSync >= intervalFor(folder, state, now);
+}
+
+void SyncScheduler::didSync(Folder & folder) {
+    lock_guard<mutex> lock(mtx);
+    states[folder.id()].lastSync = time(0);
+}
+
+int SyncScheduler::deepScanInterval(Folder & folder) {
+    lock_guard<mutex> lock(mtx);
+    FolderState & state = states[folder.id()];
+    // Deep scans re-read the flags of the whole folder. Run them every 5 minutes for
+    // folders we sync every 30 seconds, and never less often than every 10 minutes.
+    return min(intervalFor(folder, state, time(0)) * 10, MAX_DEEP_SCAN_INTERVAL);
+}
+
+void SyncScheduler::sortByPriority(vector<shared_ptr<Folder>> & folders) {
+    lock_guard<mutex> lock(mtx);
+    time_t now = time(0);
+    map<string, double> scores;
+
+    for (auto & folder : folders) {
+        FolderState & state = states[folder->id()];
+        bool focused = focusedUntil.count(folder->id()) && focusedUntil[folder->id()] > now;
+        bool changed = state.lastChange > state.lastSync;
+        double overdue = (double)(now - state.lastSync) / intervalFor(*folder, state, now);
+        scores[folder->id()] = (focused ? 1e6 : 0) + (changed ? 1e3 : 0) + min(overdue, 999.0);
+    }
+
+    // Ties (e.g. every folder on the first pass after launch) go to the most important role.
+    array<string, 7> roleOrder{"inbox", "sent", "drafts", "all", "archive", "trash", "spam"};
+    stable_sort(folders.begin(), folders.end(), [&scores, &roleOrder](const shared_ptr<Folder> & lhs, const shared_ptr<Folder> & rhs) {
+        double lhsScore = scores[lhs->id()];
+        double rhsScore = scores[rhs->id()];
+        if (lhsScore != rhsScore) {
+            return lhsScore > rhsScore;
+        }
+        ptrdiff_t lhsRank = find(roleOrder.begin(), roleOrder.end(), lhs->role()) - roleOrder.begin();
+        ptrdiff_t rhsRank = find(roleOrder.begin(), roleOrder.end(), rhs->role()) - roleOrder.begin();
+        return lhsRank < rhsRank;
+    });
+}
+
+int SyncScheduler::secondsUntilNextSync(vector<shared_ptr<Folder>> & folders) {
+    lock_guard<mutex> lock(mtx);
+    time_t now = time(0);
+    long long soonest = MAX_SLEEP_INTERVAL;
+
+    for (auto & folder : folders) {
+        FolderState & state = states[folder->id()];
+        long long remaining = (long long)(state.lastSync + intervalFor(*folder, state, now)) - now;
+        soonest = min(soonest, remaining);
+    }
+    return (int)max(soonest, (long long)MIN_SYNC_INTERVAL / 2);
+}
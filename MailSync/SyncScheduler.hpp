@@ -0,0 +1,69 @@
+//
+//  SyncScheduler.hpp
+//  MailSync
+//
+//  Copyright © 2026 Foundry 376. All rights reserved.
+//
+//  Use of this file is subject to the terms and conditions defined
+//  in 'LICENSE.md', which is part of the Mailspring-Sync package.
+//
+
+#ifndef SyncScheduler_hpp
+#define SyncScheduler_hpp
+
+#include <stdio.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <MailCore/MailCore.h>
+
+#include "Folder.hpp"
+
+using namespace std;
+using namespace mailcore;
+
+// Decides how often each folder is scanned by the background worker. Folders that
+// changed recently, that the user is looking at, or that change often are synced
+// every minute or less. Large folders nobody touches are only scanned every hour.
+// State is kept in memory - after a relaunch every folder is due once.
+class SyncScheduler {
+    struct FolderState {
+        time_t lastSync = 0;
+        time_t lastChange = 0;
+        time_t lastObservation = 0;
+        time_t firstObservation = 0;
+        double changeRate = 0;
+        uint32_t uidNext = 0;
+        uint64_t highestModSeq = 0;
+        uint32_t messageCount = 0;
+    };
+
+    mutex mtx;
+    map<string, FolderState> states;
+    map<string, time_t> focusedUntil;
+
+    int intervalFor(Folder & folder, FolderState & state, time_t now);
+
+public:
+    // Client hint: the user is looking at these folders right now.
+    void focusFolders(vector<string> & folderIds);
+
+    // Compares the status with the one seen previously and records a change if they differ.
+    // Returns true if the folder changed (or was never observed).
+    bool observeStatus(Folder & folder, IMAPFolderStatus & status);
+
+    bool isDue(Folder & folder);
+    void didSync(Folder & folder);
+
+    // Number of seconds between deep scans of a folder without CONDSTORE. At most 10 minutes.
+    int deepScanInterval(Folder & folder);
+
+    // Most urgent first: focused folders, then changed ones, then the most overdue.
+    void sortByPriority(vector<shared_ptr<Folder>> & folders);
+
+    int secondsUntilNextSync(vector<shared_ptr<Folder>> & folders);
+};
+
+#endif /* SyncScheduler_hpp */
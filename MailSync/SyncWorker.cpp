@@ -24,12 +24,32 @@
 #include "ProgressCollectors.hpp"
 #include "SyncException.hpp"
 
+#if defined(_MSC_VER)
+#include <codecvt>
+#include <locale>
+#endif
+
 
 #define CACHE_CLEANUP_INTERVAL      60 * 60
 #define SHALLOW_SCAN_INTERVAL       60 * 2
-#define DEEP_SCAN_INTERVAL          60 * 10
+
+// Header sync stops starting new folders after this long. The remaining folders
+// are picked up by the next pass, most urgent first.
+#define SYNC_PASS_BUDGET_SECONDS    45
 
 #define MAX_FULL_HEADERS_REQUEST_SIZE  1024
+#define UID_REMAP_REQUEST_SIZE         5000
+
+// Body sync batches are sized so that fetching them takes roughly this long,
+// leaving the rest of each pass for header sync.
+#define BODY_SYNC_TARGET_SECONDS    10
+#define BODY_SYNC_MIN_BATCH         10
+#define BODY_SYNC_MAX_BATCH         250
+
+// The foreground worker only fetches a few bodies after each IDLE wakeup so it gets
+// back to remote tasks and IDLE quickly. The background worker does the backfill.
+#define IDLE_BODY_SYNC_MAX_BATCH    30
+#define BODY_SYNC_RECENT_WINDOW     60 * 60 * 24 * 7
 #define MODSEQ_TRUNCATION_THRESHOLD 4000
 #define MODSEQ_TRUNCATION_UID_COUNT 12000
 
@@ -56,6 +76,9 @@ SyncWorker::SyncWorker(shared_ptr<Account> account) :
     store(new MailStore()),
     account(account),
     unlinkPhase(1),
+    bodyFetchLatencyMs(250),
+    bodyFetchBytesPerSec(256 * 1024),
+    bodyFetchAvgBytes(48 * 1024),
     logger(spdlog::get("logger")),
     processor(new MailProcessor(account, store)),
     session(IMAPSession())
@@ -178,9 +201,7 @@ void SyncWorker::idleCycleIteration()
             rowid = max(rowid, statement.getColumn("rowid").getInt());
         }
         statement.reset();
-        for (auto & task : tasks) {
-            processor.performRemote(task.get());
-        }
+        processor.performRemoteTasks(tasks);
     } while (tasks.size() > 0);
 
     if (idleShouldReloop) {
@@ -199,58 +220,13 @@ void SyncWorker::idleCycleIteration()
             throw SyncException("no-inbox", "There is no inbox or all folder to IDLE on.", false);
         }
     }
-    json inboxInitialStatus { inbox->localStatus() };
-    
     if (idleShouldReloop) {
         idleShouldReloop = false;
         return;
     }
     
     // Check for mail in the preferred idle folder (inbox / all)
-    // Must verify both key presence AND that value is a number (not null) to prevent
-    // JSON type_error exception when calling .get<uint32_t>() below
-    bool hasStartedSyncingFolder = inbox->localStatus().count(LS_SYNCED_MIN_UID) > 0 &&
-                                   inbox->localStatus()[LS_SYNCED_MIN_UID].is_number();
-
-    if (hasStartedSyncingFolder) {
-        // Process VANISHED notifications received during the previous IDLE session.
-        // The server sends VANISHED during IDLE when messages are expunged, but won't
-        // re-report them in the subsequent FETCH CHANGEDSINCE since it considers this
-        // connection already informed. We must process them here before they're lost.
-        IndexSet * idleVanished = session.idleVanishedMessages();
-        if (idleVanished != NULL && idleVanished->count() > 0) {
-            logger->info("Processing {} VANISHED UIDs from IDLE on {}", idleVanished->count(), inbox->path());
-            vector<Query> queries = MailUtils::queriesForUIDRangesInIndexSet(inbox->id(), idleVanished);
-            for (Query & query : queries) {
-                this->processor->unlinkMessagesMatchingQuery(query, unlinkPhase);
-            }
-        }
-
-        String path = AS_MCSTR(inbox->path());
-        IMAPFolderStatus remoteStatus = session.folderStatus(&path, &err);
-
-        // Note: If we have CONDSTORE but don't have QRESYNC, this if/else may result
-        // in us not seeing "vanished" messages until the next shallow sync iteration.
-        // Right now I think that's fine.
-        if (session.storedCapabilities()->containsIndex(IMAPCapabilityCondstore)) {
-            syncFolderChangesViaCondstore(*inbox, remoteStatus, false);
-        } else {
-            uint32_t uidnext = remoteStatus.uidNext();
-            uint32_t syncedMinUID = inbox->localStatus()[LS_SYNCED_MIN_UID].get<uint32_t>();
-            uint32_t bottomUID = store->fetchMessageUIDAtDepth(*inbox, 100, uidnext);
-            if (bottomUID < syncedMinUID) { bottomUID = syncedMinUID; }
-            // Guard against underflow if uidnext <= bottomUID (server inconsistency)
-            if (uidnext > bottomUID) {
-                syncFolderUIDRange(*inbox, RangeMake(bottomUID, uidnext - bottomUID), false);
-            }
-            inbox->localStatus()[LS_LAST_SHALLOW] = time(0);
-            inbox->localStatus()[LS_UIDNEXT] = uidnext;
-        }
-
-        syncMessageBodies(*inbox, remoteStatus);
-        
-        store->saveFolderStatus(inbox.get(), inboxInitialStatus);
-    }
+    syncIdleFolderChanges(*inbox);
 
     // Idle on the folder
     
@@ -259,16 +235,7 @@ void SyncWorker::idleCycleIteration()
         return;
     }
     if (session.setupIdle()) {
-        logger->info("Idling on folder {}", inbox->path());
-        String path = AS_MCSTR(inbox->path());
-        session.idle(&path, 0, &err);
-        session.unsetupIdle();
-        logger->info("Idle exited with code {}", err);
-        
-        // Ben Note: We don't throw these errors because Yandex (maybe others) abruptly and
-        // randomly close IDLE connections - and that's ok! The point is to idle "for a while"
-        // and then reconnect and idle again. If the reconnect fails on the next iteration,
-        // /that/ error will propagate up and trigger the `retryable=true` flow.
+        idleOnFolder(*inbox);
     } else {
         logger->info("Connection does not support idling. Locking until more to do...");
         std::unique_lock<std::mutex> lck(idleMtx);
@@ -276,6 +243,111 @@ void SyncWorker::idleCycleIteration()
     }
 }
 
+void SyncWorker::syncIdleFolderChanges(Folder & folder)
+{
+    json initialStatus { folder.localStatus() };
+    ErrorCode err = ErrorCode::ErrorNone;
+
+    // Must verify both key presence AND that value is a number (not null) to prevent
+    // JSON type_error exception when calling .get<uint32_t>() below
+    bool hasStartedSyncingFolder = folder.localStatus().count(LS_SYNCED_MIN_UID) > 0 &&
+                                   folder.localStatus()[LS_SYNCED_MIN_UID].is_number();
+
+    if (!hasStartedSyncingFolder) {
+        return;
+    }
+
+    // Process VANISHED notifications received during the previous IDLE session.
+    // The server sends VANISHED during IDLE when messages are expunged, but won't
+    // re-report them in the subsequent FETCH CHANGEDSINCE since it considers this
+    // connection already informed. We must process them here before they're lost.
+    IndexSet * idleVanished = session.idleVanishedMessages();
+    if (idleVanished != NULL && idleVanished->count() > 0) {
+        logger->info("Processing {} VANISHED UIDs from IDLE on {}", idleVanished->count(), folder.path());
+        vector<Query> queries = MailUtils::queriesForUIDRangesInIndexSet(folder.id(), idleVanished);
+        for (Query & query : queries) {
+            this->processor->unlinkMessagesMatchingQuery(query, unlinkPhase);
+        }
+    }
+
+    String path(folder.path().c_str());
+    IMAPFolderStatus remoteStatus = session.folderStatus(&path, &err);
+
+    // Note: If we have CONDSTORE but don't have QRESYNC, this if/else may result
+    // in us not seeing "vanished" messages until the next shallow sync iteration.
+    // Right now I think that's fine.
+    if (session.storedCapabilities()->containsIndex(IMAPCapabilityCondstore)) {
+        syncFolderChangesViaCondstore(folder, remoteStatus, false);
+    } else {
+        uint32_t uidnext = remoteStatus.uidNext();
+        uint32_t syncedMinUID = folder.localStatus()[LS_SYNCED_MIN_UID].get<uint32_t>();
+        uint32_t bottomUID = store->fetchMessageUIDAtDepth(folder, 100, uidnext);
+        if (bottomUID < syncedMinUID) { bottomUID = syncedMinUID; }
+        // Guard against underflow if uidnext <= bottomUID (server inconsistency)
+        if (uidnext > bottomUID) {
+            syncFolderUIDRange(folder, RangeMake(bottomUID, uidnext - bottomUID), false);
+        }
+        folder.localStatus()[LS_LAST_SHALLOW] = time(0);
+        folder.localStatus()[LS_UIDNEXT] = uidnext;
+    }
+
+    syncMessageBodies({&folder}, IDLE_BODY_SYNC_MAX_BATCH);
+    
+    store->saveFolderStatus(&folder, initialStatus);
+}
+
+void SyncWorker::idleOnFolder(Folder & folder)
+{
+    ErrorCode err = ErrorCode::ErrorNone;
+
+    logger->info("Idling on folder {}", folder.path());
+    String path(folder.path().c_str());
+    session.idle(&path, 0, &err);
+    session.unsetupIdle();
+    logger->info("Idle exited with code {}", err);
+    
+    // Ben Note: We don't throw these errors because Yandex (maybe others) abruptly and
+    // randomly close IDLE connections - and that's ok! The point is to idle "for a while"
+    // and then reconnect and idle again. If the reconnect fails on the next iteration,
+    // /that/ error will propagate up and trigger the `retryable=true` flow.
+}
+
+// Push Behaviors
+
+bool SyncWorker::pushCycleIteration(string role)
+{
+    // Push workers hold their own connection and IDLE on a single folder other than the
+    // inbox, so changes to it are picked up within a second instead of on the next
+    // background sync pass. Each wake-up syncs just that folder.
+    AutoreleasePool pool;
+
+    // On Gmail, sent and drafts are labels and the inbox IDLE already covers them.
+    auto folder = store->find<Folder>(Query().equal("accountId", account->id()).equal("role", role));
+    if (folder.get() == nullptr) {
+        logger->info("No {} folder to IDLE on.", role);
+        return false;
+    }
+
+    ErrorCode err = ErrorCode::ErrorNone;
+    session.connectIfNeeded(&err);
+    if (err != ErrorCode::ErrorNone) {
+        throw SyncException(err, "connectIfNeeded");
+    }
+    session.loginIfNeeded(&err);
+    if (err != ErrorCode::ErrorNone) {
+        throw SyncException(err, "loginIfNeeded");
+    }
+
+    syncIdleFolderChanges(*folder);
+
+    if (!session.setupIdle()) {
+        logger->info("Connection does not support idling, can't IDLE on the {} folder.", role);
+        return false;
+    }
+    idleOnFolder(*folder);
+    return true;
+}
+
 // Background Behaviors
 
 void SyncWorker::markAllFoldersBusy() {
@@ -310,23 +382,45 @@ bool SyncWorker::syncNow()
         hasQResync = false;
     }
 
-    // Identify folders to sync. On Gmail, labels are mapped to IMAP folders and
-    // we only want to sync all, spam, and trash.
-    
-    array<string, 7> roleOrder{"inbox", "sent", "drafts", "all", "archive", "trash", "spam"};
-    sort(folders.begin(), folders.end(), [&roleOrder](const shared_ptr<Folder> lhs, const shared_ptr<Folder> rhs) {
-        ptrdiff_t lhsRank = find(roleOrder.begin(), roleOrder.end(), lhs->role()) - roleOrder.begin();
-        ptrdiff_t rhsRank = find(roleOrder.begin(), roleOrder.end(), rhs->role()) - roleOrder.begin();
-        return lhsRank < rhsRank;
-    });
-    
+    // Fetch the status of every folder up front: a single LIST-STATUS command when the
+    // server supports it, pipelined STATUS commands otherwise.
+    Array * folderPaths = Array::array();
+    for (auto & folder : folders) {
+        folderPaths->addObject(AS_MCSTR(folder->path()));
+    }
+    ErrorCode statusesErr = ErrorCode::ErrorNone;
+    HashMap * remoteStatuses = session.folderStatuses(folderPaths, &statusesErr);
+    if (statusesErr != ErrorNone) {
+        throw SyncException(statusesErr, "syncNow - folderStatuses");
+    }
+
+    // Record what changed since the last pass, then visit the most urgent folders first:
+    // folders the user is looking at, folders that changed, then the most overdue.
+    map<string, bool> changedFolders;
+    for (auto & folder : folders) {
+        String path(folder->path().c_str());
+        IMAPFolderStatus * prefetchedStatus = (IMAPFolderStatus *)remoteStatuses->objectForKey(&path);
+        changedFolders[folder->id()] = prefetchedStatus == nullptr || scheduler.observeStatus(*folder, *prefetchedStatus);
+    }
+    scheduler.sortByPriority(folders);
+    scheduledFolders = folders;
+
+    int unchangedFolders = 0;
+    int deferredFolders = 0;
+    time_t passStart = time(0);
+
+    // Folder statuses are saved once, after the body sync below, so each folder produces
+    // at most one delta per pass. Note: json not json&
+    map<string, json> initialLocalStatuses;
+
     for (auto & folder : folders) {
         json & localStatus = folder->localStatus();
-        json initialLocalStatus = localStatus; // note: json not json&
+        initialLocalStatuses[folder->id()] = localStatus;
         
-        String path = AS_MCSTR(folder->path());
+        String path(folder->path().c_str());
         ErrorCode err = ErrorCode::ErrorNone;
-        IMAPFolderStatus remoteStatus = session.folderStatus(&path, &err);
+        IMAPFolderStatus * prefetchedStatus = (IMAPFolderStatus *)remoteStatuses->objectForKey(&path);
+        IMAPFolderStatus remoteStatus = prefetchedStatus != nullptr ? prefetchedStatus : session.folderStatus(&path, &err);
         bool firstChunk = false;
 
         if (err != ErrorNone) {
@@ -360,7 +454,6 @@ bool SyncWorker::syncNow()
             localStatus[LS_BODIES_WANTED] = 0; // pretend we want no message contents
             localStatus[LS_SYNCED_MIN_UID] = 1; // pretend we have scanned all the way to the oldest message
             localStatus[LS_UIDNEXT] = remoteStatus.uidNext();
-            store->saveFolderStatus(folder.get(), initialLocalStatus);
             continue;
         }
 
@@ -369,8 +462,10 @@ bool SyncWorker::syncNow()
             // in this folder can no longer be used. To recover from this, we need to:
             //
             // 1) Set remoteUID to the "UNLINKED" value for every message in the folder
-            // 2) Run a 'deep' scan which will refetch the metadata for the messages,
-            //    compute the Mailspring message IDs and re-map local models to remote UIDs.
+            // 2) Re-map local models we can identify from lightweight remote attributes
+            //    (Message-ID + date, or X-GM-MSGID) to their new remote UIDs.
+            // 3) Run a 'deep' scan which will refetch the metadata for the messages we could
+            //    not identify, and unlink-then-delete the ones that are gone.
             //
             // Notes:
             // - It's very important that this not generate deltas - because we're only changing
@@ -383,8 +478,7 @@ bool SyncWorker::syncNow()
             //   of a huge number of Message models all at once and flood the app. Hopefully
             //   this scenario is rare.
             logger->warn("UIDInvalidity! Resetting remoteFolderUIDs, rebuilding index. This may take a moment...");
-            processor->unlinkMessagesMatchingQuery(Query().equal("remoteFolderId", folder->id()), unlinkPhase);
-            syncFolderUIDRange(*folder, RangeMake(1, UINT64_MAX), false);
+            recoverFromUIDInvalidity(*folder, remoteStatus);
 
             if (localStatus.count(LS_UIDVALIDITY_RESET_COUNT) == 0) {
                 localStatus[LS_UIDVALIDITY_RESET_COUNT] = 1;
@@ -397,12 +491,44 @@ bool SyncWorker::syncNow()
             localStatus[LS_LAST_SHALLOW] = time(0);
             localStatus[LS_LAST_DEEP] = time(0);
             
-            store->saveFolderStatus(folder.get(), initialLocalStatus);
+            // Save right away so an error later in the pass doesn't repeat the recovery.
+            store->saveFolderStatus(folder.get(), initialLocalStatuses[folder->id()]);
+            initialLocalStatuses[folder->id()] = localStatus;
+            scheduler.didSync(*folder);
             continue;
         }
         
-        // Step 2: Initial sync. Until we reach UID 1, we grab chunks of messages
+        // Step 1.6: Skip folders the scheduler says can wait. Folders still doing their initial
+        // scan are never skipped, and STATUS changes always trigger a scan. Once the budget
+        // for this pass is spent, everything else waits for the next pass.
         uint32_t syncedMinUID = localStatus[LS_SYNCED_MIN_UID].get<uint32_t>();
+        bool changed = changedFolders[folder->id()];
+
+        if (!firstChunk && syncedMinUID == 1 && !changed && !scheduler.isDue(*folder)) {
+            continue;
+        }
+        if (time(0) - passStart > SYNC_PASS_BUDGET_SECONDS) {
+            deferredFolders += 1;
+            syncAgainImmediately = true;
+            continue;
+        }
+
+        // Step 1.75: Skip folders that have not changed. With CONDSTORE and QRESYNC every change
+        // to the folder bumps HIGHESTMODSEQ, so if it and UIDNEXT match what we have stored and
+        // the initial scan is complete there is nothing to fetch.
+        time_t lastCleanup = localStatus.count(LS_LAST_CLEANUP) ? localStatus[LS_LAST_CLEANUP].get<time_t>() : 0;
+
+        if (hasCondstore && hasQResync && syncedMinUID == 1 &&
+            (time(0) - lastCleanup <= CACHE_CLEANUP_INTERVAL) &&
+            localStatus[LS_UIDNEXT].get<uint32_t>() == remoteStatus.uidNext() &&
+            localStatus[LS_HIGHESTMODSEQ].get<uint64_t>() == remoteStatus.highestModSeqValue()) {
+            unchangedFolders += 1;
+            localStatus[LS_BUSY] = false;
+            scheduler.didSync(*folder);
+            continue;
+        }
+
+        // Step 2: Initial sync. Until we reach UID 1, we grab chunks of messages
         uint32_t chunkSize = firstChunk ? 750 : 5000;
 
         if (syncedMinUID > 1) {
@@ -430,7 +556,7 @@ bool SyncWorker::syncNow()
             uint32_t remoteUidnext = remoteStatus.uidNext();
             uint32_t localUidnext = localStatus[LS_UIDNEXT].get<uint32_t>();
             bool newMessages = remoteUidnext > localUidnext;
-            bool timeForDeepScan = (iterationsSinceLaunch > 0) && (time(0) - localStatus[LS_LAST_DEEP].get<time_t>() > DEEP_SCAN_INTERVAL);
+            bool timeForDeepScan = (iterationsSinceLaunch > 0) && (time(0) - localStatus[LS_LAST_DEEP].get<time_t>() > scheduler.deepScanInterval(*folder));
             bool timeForShallowScan = !timeForDeepScan && (time(0) - localStatus[LS_LAST_SHALLOW].get<time_t>() > SHALLOW_SCAN_INTERVAL);
 
             // Okay. If there are new messages in the folder (UIDnext has increased), do a heavy fetch of
@@ -484,11 +610,6 @@ bool SyncWorker::syncNow()
         
         bool moreToDo = false;
 
-        // Retrieve some message bodies. We do this concurrently with the full header
-        // scan so the user sees snippets on some messages quickly.
-        if (syncMessageBodies(*folder, remoteStatus)) {
-            moreToDo = true;
-        }
         if (syncedMinUID > 1) {
             moreToDo = true;
         }
@@ -496,7 +617,6 @@ bool SyncWorker::syncNow()
         // Update cache metrics and cleanup bodies we don't want anymore.
         // these queries are expensive so we do this infrequently and increment
         // blindly as we download bodies.
-        time_t lastCleanup = localStatus.count(LS_LAST_CLEANUP) ? localStatus[LS_LAST_CLEANUP].get<time_t>() : 0;
         if (syncedMinUID == 1 && (time(0) - lastCleanup > CACHE_CLEANUP_INTERVAL)) {
             cleanMessageCache(*folder);
             localStatus[LS_LAST_CLEANUP] = time(0);
@@ -506,12 +626,31 @@ bool SyncWorker::syncNow()
         // like syncing message bodies. Set to true below.
         localStatus[LS_BUSY] = moreToDo;
         syncAgainImmediately = syncAgainImmediately || moreToDo;
-
-        // Save the folder - note that helper methods above mutated localStatus.
-        // Avoid the save if we can, because this creates a lot of noise in the client.
-        store->saveFolderStatus(folder.get(), initialLocalStatus);
+        scheduler.didSync(*folder);
     }
     
+    logger->info("SyncNow: {} of {} folders unchanged since the last pass, {} deferred to the next pass.", unchangedFolders, folders.size(), deferredFolders);
+
+    // Retrieve some message bodies across all folders, most important first. We do this
+    // concurrently with the full header scan so the user sees snippets on some messages quickly.
+    {
+        vector<Folder *> bodyFolders;
+        for (auto & folder : folders) {
+            bodyFolders.push_back(folder.get());
+        }
+        if (syncMessageBodies(bodyFolders)) {
+            syncAgainImmediately = true;
+        }
+    }
+
+    // Save the folders - note that helper methods above mutated localStatus.
+    // Avoid the save if we can, because this creates a lot of noise in the client.
+    for (auto & folder : folders) {
+        if (initialLocalStatuses.count(folder->id())) {
+            store->saveFolderStatus(folder.get(), initialLocalStatuses[folder->id()]);
+        }
+    }
+
     // We've just unlinked a bunch of messages with PHASE A, now we'll delete the ones
     // with PHASE B. This ensures anything we /just/ discovered was missing gets one
     // cycle to appear in another folder before we decide it's really, really gone.
@@ -519,12 +658,23 @@ bool SyncWorker::syncNow()
     logger->info("Sync loop deleting unlinked messages with phase {}.", unlinkPhase);
     processor->deleteMessagesStillUnlinkedFromPhase(unlinkPhase);
     
-    logger->info("Sync loop complete.");
+    logger->info("Sync loop complete. Interned strings: {}, autorelease pool high water mark: {}", MailUtils::internedStringStats().dump(), AutoreleasePool::highWaterMark());
+    AutoreleasePool::resetHighWaterMark();
     iterationsSinceLaunch += 1;
 
     return syncAgainImmediately;
 }
 
+void SyncWorker::focusFolders(vector<string> & folderIds)
+{
+    scheduler.focusFolders(folderIds);
+}
+
+int SyncWorker::secondsUntilNextSync()
+{
+    return scheduler.secondsUntilNextSync(scheduledFolders);
+}
+
 void SyncWorker::ensureRootMailspringFolder(vector<string> containerFolderComponents, Array * remoteFolders)
 {
     auto components = Array::array();
@@ -816,8 +966,7 @@ void SyncWorker::syncFolderUIDRange(Folder & folder, Range range, bool heavyInit
     IndexSet * heavyNeeded = IndexSet::indexSet();
     IMAPProgress cb;
     ErrorCode err(ErrorCode::ErrorNone);
-    String path(AS_MCSTR(remotePath));
-    int heavyNeededIdeal = 0;
+    String path(remotePath.c_str());
     
     // Step 1: Fetch the local attributes (unread, starred, etc.)
     // Note: we do this first because the remote fetch may take a long time, and if the data that
@@ -826,19 +975,16 @@ void SyncWorker::syncFolderUIDRange(Folder & folder, Range range, bool heavyInit
     // in the stale server set and will be marked for deletion. Re-downloading is better.
     map<uint32_t, MessageAttributes> local(store->fetchMessagesAttributesInRange(range, folder));
 
-    // Step 2: Fetch the remote attributes (unread, starred, etc.) for the same UID range
+    // Step 2: Fetch the remote attributes (unread, starred, etc.) for the same UID range.
+    // Messages are streamed: each one is compared (and inserted if the request is heavy)
+    // as soon as it is parsed, so the chunk is never held in memory all at once.
     time_t syncDataTimestamp = time(0);
     auto kind = MailUtils::messagesRequestKindFor(session.storedCapabilities(), heavyInitialRequest);
-    Array * remote = session.fetchMessagesByUID(&path, kind, set, &cb, &err);
-    if (err) {
-        throw SyncException(err, "syncFolderUIDRange - fetchMessagesByUID");
-    }
-
     clock_t lastSleepClock = clock();
+    size_t remoteCount = 0;
+    vector<uint32_t> heavyNeededUIDs {};
 
-    logger->info("- {}: remote={}, local={}, remoteUID={}", remotePath, remote->count(), local.size(), folder.id());
-
-    for (int ii = ((int)remote->count()) - 1; ii >= 0; ii--) {
+    IMAPMessageStream stream([&](IMAPMessage * remoteMsg) {
         // Never sit in a hard loop inserting things into the database for more than 250ms.
         // This ensures we don't starve another thread waiting for a database connection
         if (((clock() - lastSleepClock) * 4) / CLOCKS_PER_SEC > 1) {
@@ -846,8 +992,8 @@ void SyncWorker::syncFolderUIDRange(Folder & folder, Range range, bool heavyInit
             lastSleepClock = clock();
         }
         
-        IMAPMessage * remoteMsg = (IMAPMessage *)(remote->objectAtIndex(ii));
         uint32_t remoteUID = remoteMsg->uid();
+        remoteCount += 1;
 
         // Step 3: Collect messages that are different or not in our local UID set.
         bool inFolder = (local.count(remoteUID) > 0);
@@ -868,14 +1014,30 @@ void SyncWorker::syncFolderUIDRange(Folder & folder, Range range, bool heavyInit
                     syncedMessages->push_back(local);
                 }
             } else {
-                if (heavyNeededIdeal < MAX_FULL_HEADERS_REQUEST_SIZE) {
-                    heavyNeeded->addIndex(remoteUID);
-                }
-                heavyNeededIdeal += 1;
+                heavyNeededUIDs.push_back(remoteUID);
             }
         }
         
         local.erase(remoteUID);
+    });
+
+    session.fetchMessagesByUIDStreaming(&path, kind, set, &stream, &cb, &err);
+    stream.rethrowIfFailed();
+    if (err) {
+        throw SyncException(err, "syncFolderUIDRange - fetchMessagesByUID");
+    }
+
+    logger->info("- {}: remote={}, local={}, remoteUID={}", remotePath, remoteCount, local.size(), folder.id());
+
+    // Messages arrive in ascending UID order. Prefer the newest ones when we
+    // can't fetch full headers for all of them in this pass.
+    int heavyNeededIdeal = (int)heavyNeededUIDs.size();
+    sort(heavyNeededUIDs.begin(), heavyNeededUIDs.end(), std::greater<uint32_t>());
+    for (uint32_t uid : heavyNeededUIDs) {
+        if (heavyNeeded->count() >= MAX_FULL_HEADERS_REQUEST_SIZE) {
+            break;
+        }
+        heavyNeeded->addIndex(uid);
     }
     
     if (!heavyInitialRequest && heavyNeeded->count() > 0) {
@@ -891,17 +1053,16 @@ void SyncWorker::syncFolderUIDRange(Folder & folder, Range range, bool heavyInit
         //
         syncDataTimestamp = time(0);
         auto kind = MailUtils::messagesRequestKindFor(session.storedCapabilities(), true);
-        remote = session.fetchMessagesByUID(&path, kind, heavyNeeded, &cb, &err);
-        if (err != ErrorNone) {
-            throw SyncException(err, "syncFolderUIDRange - fetchMessagesByUID (heavy)");
-        }
-        for (int ii = ((int)remote->count()) - 1; ii >= 0; ii--) {
-            IMAPMessage * remoteMsg = (IMAPMessage *)(remote->objectAtIndex(ii));
+        IMAPMessageStream heavyStream([&](IMAPMessage * remoteMsg) {
             auto local = processor->insertFallbackToUpdateMessage(remoteMsg, folder, syncDataTimestamp);
             if (syncedMessages != nullptr) {
                 syncedMessages->push_back(local);
             }
-            remote->removeLastObject();
+        });
+        session.fetchMessagesByUIDStreaming(&path, kind, heavyNeeded, &heavyStream, &cb, &err);
+        heavyStream.rethrowIfFailed();
+        if (err != ErrorNone) {
+            throw SyncException(err, "syncFolderUIDRange - fetchMessagesByUID (heavy)");
         }
     }
 
@@ -920,6 +1081,56 @@ void SyncWorker::syncFolderUIDRange(Folder & folder, Range range, bool heavyInit
     }
 }
 
+void SyncWorker::recoverFromUIDInvalidity(Folder & folder, IMAPFolderStatus & remoteStatus)
+{
+    AutoreleasePool pool;
+    String path(folder.path().c_str());
+    bool gmail = session.storedCapabilities()->containsIndex(IMAPCapabilityGmail);
+    uint32_t messageCount = remoteStatus.messageCount();
+
+    // Step 1: Fetch just enough to identify each remote message, in chunks of sequence
+    // numbers so each response has a predictable size. Keys seen more than once are
+    // ambiguous and left for the deep scan to sort out.
+    map<string, uint32_t> remoteUIDsByKey {};
+    set<string> duplicateKeys {};
+    Array * extraHeaders = gmail ? nullptr : Array::arrayWithObject(MCSTR("Message-ID"));
+    if (extraHeaders) {
+        extraHeaders->addObject(MCSTR("Date"));
+    }
+    auto kind = gmail ? IMAPMessagesRequestKindGmailMessageID : IMAPMessagesRequestKindInternalDate;
+
+    for (uint32_t start = 1; start <= messageCount; start += UID_REMAP_REQUEST_SIZE) {
+        AutoreleasePool chunkPool;
+        ErrorCode err = ErrorNone;
+        uint32_t length = min((uint32_t)UID_REMAP_REQUEST_SIZE, messageCount - start + 1);
+        IndexSet * numbers = IndexSet::indexSetWithRange(RangeMake(start, length - 1));
+        Array * remote = session.fetchMessagesByNumberWithExtraHeaders(&path, kind, numbers, nullptr, extraHeaders, &err);
+        if (err != ErrorNone) {
+            throw SyncException(err, "recoverFromUIDInvalidity - fetchMessagesByNumber");
+        }
+        for (unsigned int ii = 0; ii < remote->count(); ii ++) {
+            IMAPMessage * msg = (IMAPMessage *)remote->objectAtIndex(ii);
+            string key = processor->uidRemapKeyForMessage(msg, gmail);
+            if (key == "") {
+                continue;
+            }
+            if (!remoteUIDsByKey.emplace(key, msg->uid()).second) {
+                duplicateKeys.insert(key);
+            }
+        }
+    }
+    for (auto & key : duplicateKeys) {
+        remoteUIDsByKey.erase(key);
+    }
+
+    // Step 2: Unlink the folder and re-map the messages we could identify
+    processor->remapMessageUIDsInFolder(folder, remoteUIDsByKey, gmail, unlinkPhase);
+
+    // Step 3: Sync attributes of the whole folder. Re-mapped messages are only compared,
+    // the rest get their full headers fetched (capped per pass) or remain unlinked.
+    syncFolderUIDRange(folder, RangeMake(1, UINT64_MAX), false);
+}
+
 void SyncWorker::syncFolderChangesViaCondstore(Folder & folder, IMAPFolderStatus & remoteStatus, bool mustSyncAll)
 {
     // allocated mailcore objects freed when `pool` is removed from the stack
@@ -952,7 +1163,7 @@ void SyncWorker::syncFolderChangesViaCondstore(Folder & folder, IMAPFolderStatus
 
     IMAPProgress cb;
     ErrorCode err = ErrorCode::ErrorNone;
-    String path(AS_MCSTR(folder.path()));
+    String path(folder.path().c_str());
     
     auto kind = MailUtils::messagesRequestKindFor(session.storedCapabilities(), true);
     IMAPSyncResult * result = session.syncMessagesByUID(&path, kind, uids, modseq, &cb, &err);
@@ -1019,7 +1230,7 @@ void SyncWorker::cleanMessageCache(Folder & folder) {
 // Message Body Sync
 
 time_t SyncWorker::maxAgeForBodySync(Folder & folder) {
-    return 24 * 60 * 60 * 30 * 3; // three months TODO pref!
+    return 24 * 60 * 60 * (time_t)account->bodySyncMaxAgeDays();
 }
 
 bool SyncWorker::shouldCacheBodiesInFolder(Folder & folder) {
@@ -1049,29 +1260,63 @@ long long SyncWorker::countBodiesNeeded(Folder & folder) {
 }
 
 /*
- Syncs the top N missing message bodies. Returns true if it did work, false if it did nothing.
+ Returns the number of bodies to fetch in the next pass. This is sized from the
+ observed latency and throughput of recent body fetches so each pass takes about
+ BODY_SYNC_TARGET_SECONDS, and is capped by the account's byte budget.
  */
-bool SyncWorker::syncMessageBodies(Folder & folder, IMAPFolderStatus & remoteStatus) {
-    if (!shouldCacheBodiesInFolder(folder)) {
+size_t SyncWorker::bodySyncBatchSize() {
+    double secondsPerBody = bodyFetchLatencyMs / 1000.0 + bodyFetchAvgBytes / max(1.0, bodyFetchBytesPerSec);
+    double bySpeed = BODY_SYNC_TARGET_SECONDS / max(0.001, secondsPerBody);
+    double byBudget = account->bodySyncByteBudget() / max(1.0, bodyFetchAvgBytes);
+    double size = min(bySpeed, byBudget);
+    return (size_t)max((double)BODY_SYNC_MIN_BATCH, min((double)BODY_SYNC_MAX_BATCH, size));
+}
+
+/*
+ Syncs the top N missing message bodies across the given folders, up to maxBatchSize.
+ Bodies are prioritized by recency, with unread messages from the last week first.
+ Returns true if it did work, false if it did nothing.
+ */
+bool SyncWorker::syncMessageBodies(vector<Folder *> folders, size_t maxBatchSize) {
+    map<string, Folder *> foldersById;
+    vector<string> folderIds;
+    for (auto folder : folders) {
+        if (!shouldCacheBodiesInFolder(*folder)) {
+            continue;
+        }
+        foldersById[folder->id()] = folder;
+        folderIds.push_back(folder->id());
+    }
+    if (folderIds.empty()) {
         return false;
     }
 
+    size_t batchSize = min(bodySyncBatchSize(), maxBatchSize);
+    time_t now = time(0);
     vector<string> ids{};
     vector<shared_ptr<Message>> results{};
 
     // very slow query = 400ms+
-    SQLite::Statement missing(store->db(), "SELECT Message.id, Message.remoteUID FROM Message LEFT JOIN MessageBody ON MessageBody.id = Message.id WHERE Message.accountId = ? AND Message.remoteFolderId = ? AND (Message.date > ? OR Message.draft = 1) AND Message.remoteUID > 0 AND MessageBody.id IS NULL ORDER BY Message.date DESC LIMIT 30");
-    missing.bind(1, folder.accountId());
-    missing.bind(2, folder.id());
-    missing.bind(3, (double)(time(0) - maxAgeForBodySync(folder))); // three months TODO pref!
+    SQLite::Statement missing(store->db(), "SELECT Message.id, Message.remoteUID, Message.remoteFolderId FROM Message LEFT JOIN MessageBody ON MessageBody.id = Message.id WHERE Message.accountId = ? AND Message.remoteFolderId IN (" + MailUtils::qmarks(folderIds.size()) + ") AND (Message.date > ? OR Message.draft = 1) AND Message.remoteUID > 0 AND MessageBody.id IS NULL ORDER BY (Message.date > ?) DESC, Message.unread DESC, Message.date DESC LIMIT ?");
+    int col = 1;
+    missing.bind(col++, account->id());
+    for (auto & id : folderIds) {
+        missing.bind(col++, id);
+    }
+    missing.bind(col++, (double)(now - maxAgeForBodySync(*folders.front())));
+    missing.bind(col++, (double)(now - BODY_SYNC_RECENT_WINDOW));
+    missing.bind(col++, (long long)batchSize);
     while (missing.executeStep()) {
         if (missing.getColumn(1).getUInt() >= UINT32_MAX - 2) {
             continue; // message is scheduled for cleanup
         }
         ids.push_back(missing.getColumn(0).getString());
     }
+    if (ids.empty()) {
+        return false;
+    }
     
-    SQLite::Statement stillMissing(store->db(), "SELECT Message.* FROM Message LEFT JOIN MessageBody ON MessageBody.id = Message.id WHERE Message.id IN (" + MailUtils::qmarks(ids.size()) + ") AND MessageBody.id IS NULL");
+    SQLite::Statement stillMissing(store->db(), "SELECT Message.* FROM Message LEFT JOIN MessageBody ON MessageBody.id = Message.id WHERE Message.id IN (" + MailUtils::qmarks(ids.size()) + ") AND MessageBody.id IS NULL ORDER BY (Message.date > ?) DESC, Message.unread DESC, Message.date DESC");
     SQLite::Statement insertPlaceholder(store->db(), "INSERT OR IGNORE INTO MessageBody (id, value) VALUES (?, ?)");
 
     {
@@ -1084,6 +1329,7 @@ bool SyncWorker::syncMessageBodies(Folder & folder, IMAPFolderStatus & remoteSta
         for (auto id : ids) {
             stillMissing.bind(ii++, id);
         }
+        stillMissing.bind(ii++, (double)(now - BODY_SYNC_RECENT_WINDOW));
         while (stillMissing.executeStep()) {
             results.push_back(make_shared<Message>(stillMissing));
         }
@@ -1104,15 +1350,24 @@ bool SyncWorker::syncMessageBodies(Folder & folder, IMAPFolderStatus & remoteSta
         transaction.commit();
     }
 
-    json & ls = folder.localStatus();
-    if (!ls.count(LS_BODIES_PRESENT) || !ls[LS_BODIES_PRESENT].is_number()) {
-        ls[LS_BODIES_PRESENT] = 0;
+    for (auto & pair : foldersById) {
+        json & ls = pair.second->localStatus();
+        if (!ls.count(LS_BODIES_PRESENT) || !ls[LS_BODIES_PRESENT].is_number()) {
+            ls[LS_BODIES_PRESENT] = 0;
+        }
     }
-    
+
+    logger->info("Fetching {} message bodies (batch size {}, ~{}ms latency, ~{} KB/s)", results.size(), batchSize, (int)bodyFetchLatencyMs, (int)(bodyFetchBytesPerSec / 1024));
+
     for (auto result : results) {
         // increment local sync state - it's fine if this sometimes fails to save,
         // we recompute the value via COUNT(*) during cleanup
-        ls[LS_BODIES_PRESENT] = ls[LS_BODIES_PRESENT].get<long long>() + 1;
+        auto folder = foldersById[result->remoteFolderId()];
+        if (folder) {
+            json & ls = folder->localStatus();
+            ls[LS_BODIES_PRESENT] = ls[LS_BODIES_PRESENT].get<long long>() + 1;
+            ls[LS_BUSY] = true;
+        }
 
         // attempt to fetch the message boy
         syncMessageBody(result.get());
@@ -1121,17 +1376,29 @@ bool SyncWorker::syncMessageBodies(Folder & folder, IMAPFolderStatus & remoteSta
     return results.size() > 0;
 }
 
-void SyncWorker::syncMessageBody(Message * message) {
+size_t SyncWorker::syncMessageBody(Message * message) {
     // allocated mailcore objects freed when `pool` is removed from the stack
     AutoreleasePool pool;
     
     IMAPProgress cb;
     ErrorCode err = ErrorCode::ErrorNone;
     string folderPath = message->remoteFolder()["path"].get<string>();
-    String path(AS_MCSTR(folderPath));
+    String path(folderPath.c_str());
     
-    Data * data = session.fetchMessageByUID(&path, message->remoteUID(), &cb, &err);
+    // Stream the literal to a temporary file and parse from a mapping of it, so
+    // large messages aren't held in memory both as the IMAP literal and a copy.
+    string tmpPath = MailUtils::pathForTemporaryFile(MailUtils::idRandomlyGenerated() + ".eml");
+#ifdef _MSC_VER
+    wstring_convert<codecvt_utf8<wchar_t>, wchar_t> convert;
+    String * tmpFile = AS_WIDE_MCSTR(convert.from_bytes(tmpPath));
+#else
+    String * tmpFile = AS_TRANSIENT_MCSTR(tmpPath);
+#endif
+
+    auto start = std::chrono::steady_clock::now();
+    session.fetchMessageToFileByUID(&path, message->remoteUID(), tmpFile, &cb, &err);
     if (err != ErrorNone) {
+        MailUtils::removeFile(tmpPath);
         logger->error("Unable to fetch body for message \"{}\" ({} UID {}). Error {}",
                       message->subject(), folderPath, message->remoteUID(), ErrorCodeToTypeMap[err]);
 
@@ -1141,21 +1408,49 @@ void SyncWorker::syncMessageBody(Message * message) {
             // can just disappear.
 
             // oh well.
-            return;
+            return 0;
         }
 
-        throw SyncException(err, "syncMessageBody - fetchMessageByUID");
-    }
-    if (data == nullptr) {
-        logger->error("fetchMessageByUID returned null data for message \"{}\" ({} UID {})",
-                      message->subject(), folderPath, message->remoteUID());
-        return;
+        throw SyncException(err, "syncMessageBody - fetchMessageToFileByUID");
     }
-    MessageParser * messageParser = MessageParser::messageParserWithData(data);
-    if (messageParser == nullptr) {
-        logger->error("MessageParser::messageParserWithData returned null for message \"{}\" ({} UID {})",
-                      message->subject(), folderPath, message->remoteUID());
-        return;
+
+    size_t length = 0;
+    try {
+        // the mapping is released when `parsePool` drains, before the file is removed
+        AutoreleasePool parsePool;
+
+        Data * data = Data::dataWithContentsOfFile(tmpFile);
+        if (data == nullptr) {
+            // empty files can't be mapped
+            data = Data::data();
+        }
+        length = data->length();
+
+        // Update our estimates of per-request latency and throughput. These are weighted
+        // averages so a single slow message doesn't throw off the next batch.
+        double elapsedMs = max(1.0, (double)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+        double bytes = (double)length;
+        double transferMs = max(1.0, elapsedMs - bodyFetchLatencyMs);
+        bodyFetchAvgBytes = bodyFetchAvgBytes * 0.9 + bytes * 0.1;
+        if (bytes < 16 * 1024) {
+            bodyFetchLatencyMs = bodyFetchLatencyMs * 0.9 + elapsedMs * 0.1;
+        } else {
+            bodyFetchBytesPerSec = bodyFetchBytesPerSec * 0.9 + (bytes / (transferMs / 1000.0)) * 0.1;
+        }
+
+        MessageParser * messageParser = MessageParser::messageParserWithData(data);
+        if (messageParser == nullptr) {
+            logger->error("MessageParser::messageParserWithData returned null for message \"{}\" ({} UID {})",
+                          message->subject(), folderPath, message->remoteUID());
+            length = 0;
+        } else {
+            processor->retrievedMessageBody(message, messageParser);
+        }
+    } catch (...) {
+        MailUtils::removeFile(tmpPath);
+        throw;
     }
-    processor->retrievedMessageBody(message, messageParser);
+
+    MailUtils::removeFile(tmpPath);
+    return length;
 }
@@ -25,6 +25,7 @@
 #include "MailProcessor.hpp"
 #include "DeltaStream.hpp"
 #include "Folder.hpp"
+#include "SyncScheduler.hpp"
 
 using namespace mailcore;
 
@@ -42,6 +43,15 @@ class SyncWorker {
     std::mutex idleMtx;
     std::condition_variable idleCv;
 
+    // Observed body fetch performance, used to size body sync batches
+    double bodyFetchLatencyMs;
+    double bodyFetchBytesPerSec;
+    double bodyFetchAvgBytes;
+
+    // Decides which folders the background worker scans on each pass
+    SyncScheduler scheduler;
+    vector<shared_ptr<Folder>> scheduledFolders;
+
 public:
     
     shared_ptr<Account> account;
@@ -57,13 +67,26 @@ public:
     void idleQueueBodiesToSync(vector<string> & ids);
     void idleCycleIteration();
 
-    
+private:
+
+    void syncIdleFolderChanges(Folder & folder);
+    void idleOnFolder(Folder & folder);
+
+#pragma mark Push Worker
+
+public:
+
+    bool pushCycleIteration(string role);
+
 #pragma mark Background Worker
 
 public:
     
     bool syncNow();
 
+    void focusFolders(vector<string> & folderIds);
+    int secondsUntilNextSync();
+
     void markAllFoldersBusy();
 
     std::vector<std::shared_ptr<Folder>> syncFoldersAndLabels();
@@ -78,6 +101,8 @@ private:
 
     void syncFolderChangesViaCondstore(Folder & folder, IMAPFolderStatus & remoteStatus, bool mustSyncAll);
 
+    void recoverFromUIDInvalidity(Folder & folder, IMAPFolderStatus & remoteStatus);
+
     void fetchRangeInFolder(String * folder, std::string folderId, Range range);
 
     void cleanMessageCache(Folder & folder);
@@ -86,8 +111,9 @@ private:
     long long countBodiesNeeded(Folder & folder);
     time_t maxAgeForBodySync(Folder & folder);
     bool shouldCacheBodiesInFolder(Folder & folder);
-    bool syncMessageBodies(Folder & folder, IMAPFolderStatus & remoteStatus);
-    void syncMessageBody(Message * message);
+    size_t bodySyncBatchSize();
+    bool syncMessageBodies(vector<Folder *> folders, size_t maxBatchSize = SIZE_MAX);
+    size_t syncMessageBody(Message * message);
 };
 
 
@@ -30,6 +30,7 @@
 
 #include <sstream>
 #include <algorithm>
+#include <set>
 #include <iomanip>
 #include <thread>
 #include <chrono>
@@ -47,6 +48,15 @@ using namespace std;
 using namespace mailcore;
 using namespace nlohmann;
 
+// Sent folder localStatus keys tracking whether the SMTP gateway files sent messages
+// into the sent folder itself. After several consecutive sends where it didn't, we
+// append our own copy while sending. Every so often we poll again in case it changed.
+#define LS_SENT_GATEWAY_MISSES  "sentGatewayMisses"
+#define LS_SENT_APPENDED_SENDS  "sentAppendedSends"
+
+#define SENT_GATEWAY_MISSES_BEFORE_APPEND   3
+#define SENT_APPENDED_SENDS_BEFORE_POLL     20
+
 static void setFileModificationTime(const string & filepath, time_t timestamp) {
 #ifdef _MSC_VER
     wstring_convert<codecvt_utf8<wchar_t>, wchar_t> convert;
@@ -504,6 +514,7 @@ void TaskProcessor::performLocal(Task * task) {
 // PerformRemote is run from the foreground worker
 
 void TaskProcessor::performRemote(Task * task) {
+    AutoreleasePool pool;
     string cname = task->constructorName();
 
     logger->info("[{}] Running {} performRemote:", task->id(), cname);
@@ -600,6 +611,49 @@ void TaskProcessor::performRemote(Task * task) {
     store->save(task);
 }
 
+// Returns the kind of change a task makes to messages when it can be merged with
+// adjacent tasks of the same kind, or an empty string if it must run on its own.
+
+static string _coalescingKindForTask(Task * task) {
+    string cname = task->constructorName();
+    if (cname == "ChangeUnreadTask" || cname == "ChangeStarredTask") {
+        return "flags";
+    }
+    if (cname == "ChangeLabelsTask") {
+        return "labels";
+    }
+    if (cname == "ChangeFolderTask") {
+        return "folder";
+    }
+    return "";
+}
+
+void TaskProcessor::performRemoteTasks(vector<shared_ptr<Task>> & tasks) {
+    // Selecting thousands of messages and toggling them produces long runs of tasks over
+    // the same messages. Adjacent tasks of the same kind are merged so each folder gets a
+    // minimal set of STORE / MOVE commands. Tasks are never reordered across kinds.
+    size_t ii = 0;
+    while (ii < tasks.size()) {
+        string kind = _coalescingKindForTask(tasks[ii].get());
+        size_t end = ii + 1;
+        if (kind != "") {
+            while (end < tasks.size() && _coalescingKindForTask(tasks[end].get()) == kind) {
+                end ++;
+            }
+        }
+        if (end - ii == 1) {
+            performRemote(tasks[ii].get());
+        } else {
+            vector<Task *> run;
+            for (size_t jj = ii; jj < end; jj ++) {
+                run.push_back(tasks[jj].get());
+            }
+            performRemoteCoalescedChangeOnMessages(run, kind);
+        }
+        ii = end;
+    }
+}
+
 void TaskProcessor::cancel(string taskId) {
     MailStoreTransaction transaction{store, "cancel"};
     auto task = store->find<Task>(Query().equal("id", taskId).equal("accountId", account->id()));
@@ -702,53 +756,59 @@ void TaskProcessor::performLocalChangeOnMessages(Task * task, void (*modifyLocal
     json & data = task->data();
     ChangeMailModels models = inflateMessages(data);
     bool recomputeThreadAttributes = data.count("threadIds");
-    
+    time_t syncedAt = time(0) + 24 * 60 * 60;
+
+    // Apply the change to all the messages in memory, remembering what each message looked
+    // like before so the threads can be updated once below instead of once per message.
+    vector<MessageSnapshot> snapshots;
+    vector<string> threadIds{};
+    set<string> threadIdsSeen{};
+    snapshots.reserve(models.messages.size());
+
     for (auto msg : models.messages) {
-        // TEMPORARY
-        if (recomputeThreadAttributes) {
-            msg->_skipThreadUpdatesAfterSave = true;
-        }
-        
+        snapshots.push_back(msg->getSnapshot());
+        msg->_skipThreadUpdatesAfterSave = true;
+
         // perform local changes
         modifyLocalMessage(msg.get(), data);
 
         // prevent remote changes to this message for 24 hours
         // so the changes aren't reverted by sync before we can syncback.
         msg->setSyncUnsavedChanges(msg->syncUnsavedChanges() + 1);
-        msg->setSyncedAt(time(0) + 24 * 60 * 60);
+        msg->setSyncedAt(syncedAt);
 
-        store->save(msg.get());
+        if (msg->threadId() != "" && threadIdsSeen.insert(msg->threadId()).second) {
+            threadIds.push_back(msg->threadId());
+        }
     }
 
-    // TEMPORARY
-    // if we were given a set of threadIds, we might as well rebalance the counters
-    // and correct any refcounting issues the user may be seeing, since we already
-    // have all the messages in memory.
-    if (recomputeThreadAttributes) {
-        vector<string> threadIds{};
-        for (auto & member : data["threadIds"]) {
-            threadIds.push_back(member.get<string>());
-        }
-        auto chunks = MailUtils::chunksOfVector(threadIds, 500);
-        auto allLabels = store->allLabelsCache(task->accountId());
+    store->saveAll(models.messages);
 
-        for (auto chunk : chunks) {
-            auto threads = store->findAllMap<Thread>(Query().equal("id", chunk), "id");
+    auto allLabels = store->allLabelsCache(task->accountId());
+    auto threads = store->findLargeSet<Thread>("id", threadIds);
+    map<string, Thread *> threadsById{};
+    for (auto & thread : threads) {
+        threadsById[thread->id()] = thread.get();
+    }
 
-            for (auto pair : threads) {
-                pair.second->resetCountedAttributes();
-            }
-            for (auto msg : models.messages) {
-                if (threads.count(msg->threadId())) {
-                    threads[msg->threadId()]->applyMessageAttributeChanges(MessageEmptySnapshot, msg.get(), allLabels);
-                }
-            }
-            for (auto pair : threads) {
-                store->save(pair.second.get());
-            }
+    // If we were given a set of threadIds, we have every message in those threads in memory
+    // and might as well rebuild the counters from scratch, correcting any refcounting issues
+    // the user may be seeing. Otherwise apply the before + after of each changed message.
+    if (recomputeThreadAttributes) {
+        for (auto & thread : threads) {
+            thread->resetCountedAttributes();
         }
     }
-    // END TEMPORARY
+    for (size_t i = 0; i < models.messages.size(); i++) {
+        Message * msg = models.messages[i].get();
+        if (!threadsById.count(msg->threadId())) {
+            continue;
+        }
+        MessageSnapshot & before = recomputeThreadAttributes ? MessageEmptySnapshot : snapshots[i];
+        threadsById[msg->threadId()]->applyMessageAttributeChanges(before, msg, allLabels);
+    }
+
+    store->saveAll(threads);
 
     transaction.commit();
 }
@@ -822,6 +882,184 @@ void TaskProcessor::performRemoteChangeOnMessages(Task * task, bool updatesFolde
     }
 }
 
+void TaskProcessor::performRemoteCoalescedChangeOnMessages(vector<Task *> tasks, string kind) {
+    AutoreleasePool pool;
+
+    vector<Task *> active;
+    for (auto task : tasks) {
+        if (task->accountId() != account->id()) {
+            performRemote(task);
+        } else if (task->shouldCancel()) {
+            logger->info("[{}] Running {} performRemote: cancelled", task->id(), task->constructorName());
+            task->setStatus("cancelled");
+            store->save(task);
+        } else {
+            active.push_back(task);
+        }
+    }
+    if (active.empty()) {
+        return;
+    }
+
+    logger->info("Running {} {} tasks as one performRemote:", active.size(), kind);
+
+    // Compute the final state of every message. Later tasks win, so opposing changes to
+    // the same message (read then unread, A -> B then B -> A) collapse into one.
+    map<string, shared_ptr<Message>> messagesById{};
+    map<string, int> tasksByMessageId{};
+    map<string, bool> finalUnread{};
+    map<string, bool> finalStarred{};
+    map<string, json> finalFolder{};
+    map<string, map<string, bool>> finalLabels{};
+
+    for (auto task : active) {
+        logger->info("[{}] -- Merged {}", task->id(), task->constructorName());
+        json & data = task->data();
+        string cname = task->constructorName();
+
+        for (auto msg : inflateMessages(data).messages) {
+            string id = msg->id();
+            if (!messagesById.count(id)) {
+                messagesById[id] = msg;
+            }
+            tasksByMessageId[id] += 1;
+
+            if (cname == "ChangeUnreadTask") {
+                finalUnread[id] = data["unread"].get<bool>();
+            } else if (cname == "ChangeStarredTask") {
+                finalStarred[id] = data["starred"].get<bool>();
+            } else if (cname == "ChangeFolderTask") {
+                finalFolder[id] = data["folder"];
+            } else if (cname == "ChangeLabelsTask") {
+                for (auto & item : data["labelsToAdd"]) {
+                    finalLabels[id][_xgmKeyForLabel(item)] = true;
+                }
+                for (auto & item : data["labelsToRemove"]) {
+                    finalLabels[id][_xgmKeyForLabel(item)] = false;
+                }
+            }
+        }
+    }
+
+    try {
+        ErrorCode err = ErrorCode::ErrorNone;
+
+        if (kind == "flags") {
+            // folder path => (flag, add) => uids
+            map<string, map<pair<MessageFlag, bool>, shared_ptr<IndexSet>>> stores{};
+            auto addStore = [&](shared_ptr<Message> & msg, MessageFlag flag, bool add) {
+                auto & set = stores[msg->remoteFolder()["path"].get<string>()][{flag, add}];
+                if (!set) {
+                    set = make_shared<IndexSet>();
+                }
+                set->addIndex(msg->remoteUID());
+            };
+            for (auto & pair : finalUnread) {
+                addStore(messagesById[pair.first], MessageFlagSeen, !pair.second);
+            }
+            for (auto & pair : finalStarred) {
+                addStore(messagesById[pair.first], MessageFlagFlagged, pair.second);
+            }
+            for (auto & folderStores : stores) {
+                for (auto & entry : folderStores.second) {
+                    IMAPStoreFlagsRequestKind storeKind = entry.first.second ? IMAPStoreFlagsRequestKindAdd : IMAPStoreFlagsRequestKindRemove;
+                    session->storeFlagsByUID(AS_MCSTR(folderStores.first), entry.second.get(), storeKind, entry.first.first, &err);
+                    if (err != ErrorCode::ErrorNone) {
+                        throw SyncException(err, "storeFlagsByUID");
+                    }
+                }
+            }
+
+        } else if (kind == "labels") {
+            // folder path => (label, add) => uids
+            map<string, map<pair<string, bool>, shared_ptr<IndexSet>>> stores{};
+            for (auto & pair : finalLabels) {
+                auto & msg = messagesById[pair.first];
+                for (auto & label : pair.second) {
+                    auto & set = stores[msg->remoteFolder()["path"].get<string>()][label];
+                    if (!set) {
+                        set = make_shared<IndexSet>();
+                    }
+                    set->addIndex(msg->remoteUID());
+                }
+            }
+            for (auto & folderStores : stores) {
+                for (auto & entry : folderStores.second) {
+                    Array * labels = Array::arrayWithObject(AS_MCSTR(entry.first.first));
+                    IMAPStoreFlagsRequestKind storeKind = entry.first.second ? IMAPStoreFlagsRequestKindAdd : IMAPStoreFlagsRequestKindRemove;
+                    session->storeLabelsByUID(AS_MCSTR(folderStores.first), entry.second.get(), storeKind, labels, &err);
+                    if (err != ErrorCode::ErrorNone) {
+                        throw SyncException(err, "storeLabelsByUID");
+                    }
+                }
+            }
+
+        } else if (kind == "folder") {
+            // (folder path, destination path) => messages
+            map<pair<string, string>, vector<shared_ptr<Message>>> moves{};
+            map<string, json> destinations{};
+            for (auto & pair : finalFolder) {
+                auto & msg = messagesById[pair.first];
+                string path = msg->remoteFolder()["path"].get<string>();
+                string destPath = pair.second["path"].get<string>();
+                if (path == destPath) {
+                    continue;
+                }
+                moves[{path, destPath}].push_back(msg);
+                destinations[destPath] = pair.second;
+            }
+            for (auto & move : moves) {
+                IndexSet * uids = IndexSet::indexSet();
+                for (auto & msg : move.second) {
+                    uids->addIndex(msg->remoteUID());
+                }
+                Folder destFolder{destinations[move.first.second]};
+                _moveMessagesResilient(session, AS_MCSTR(move.first.first), &destFolder, uids, move.second);
+            }
+        }
+    } catch (SyncException & ex) {
+        for (auto task : active) {
+            logger->error("[{}] -- Failed ({}). Changing status to `complete`", task->id(), ex.toJSON().dump());
+            task->setError(ex.toJSON());
+            task->setStatus("complete");
+            store->save(task);
+        }
+        logger->flush();
+        return;
+    }
+
+    // Reload the messages inside one transaction, save the remote attributes changed by
+    // moves and release the lock each merged task placed on the message.
+    {
+        MailStoreTransaction transaction{store, "performRemoteCoalescedChangeOnMessages"};
+        vector<string> ids{};
+        for (auto & pair : messagesById) {
+            ids.push_back(pair.first);
+        }
+        for (auto safe : store->findLargeSet<Message>("id", ids)) {
+            auto unsafe = messagesById[safe->id()];
+            if (kind == "folder") {
+                safe->setRemoteUID(unsafe->remoteUID());
+                safe->setRemoteFolder(unsafe->remoteFolder());
+            }
+            int suc = max(0, safe->syncUnsavedChanges() - tasksByMessageId[safe->id()]);
+            safe->setSyncUnsavedChanges(suc);
+            if (suc == 0) {
+                safe->setSyncedAt(time(0));
+            }
+            store->save(safe.get());
+        }
+        store->unsafeEraseTransactionDeltas();
+        transaction.commit();
+    }
+
+    for (auto task : active) {
+        logger->info("[{}] -- Succeeded. Changing status to `complete`", task->id());
+        task->setStatus("complete");
+        store->save(task);
+    }
+}
+
 void TaskProcessor::performLocalSaveDraft(Task * task) {
     json & draftJSON = task->data()["draft"];
     
@@ -1009,8 +1247,8 @@ void TaskProcessor::performLocalSyncbackContactGroup(Task * task) {
             contact->setName(name);
             contact->mutateCardInInfo([&](shared_ptr<VCard> vcard) {
                 vcard->setName(name);
-                vcard->addProperty(make_shared<VCardProperty>("FN", name));
-                vcard->addProperty(make_shared<VCardProperty>(X_VCARD3_KIND, "group"));
+                vcard->addProperty(VCardProperty("FN", name));
+                vcard->addProperty(VCardProperty(X_VCARD3_KIND, "group"));
             });
 
             task->data()["group"]["id"] = uid;
@@ -1456,31 +1694,31 @@ void TaskProcessor::performRemoteSendDraft(Task * task) {
             throw SyncException("no-self-body", "If `perRecipientBodies` is populated, you must provide a `self` entry.", false);
         }
         if (plaintext) {
-            builder.setTextBody(AS_MCSTR(perRecipientBodies["self"].get<string>()));
+            builder.setTextBody(AS_TRANSIENT_MCSTR(perRecipientBodies["self"].get<string>()));
         } else {
-            builder.setHTMLBody(AS_MCSTR(perRecipientBodies["self"].get<string>()));
+            builder.setHTMLBody(AS_TRANSIENT_MCSTR(perRecipientBodies["self"].get<string>()));
         }
     } else {
         if (plaintext) {
-            builder.setTextBody(AS_MCSTR(body));
+            builder.setTextBody(AS_TRANSIENT_MCSTR(body));
         } else {
-            builder.setHTMLBody(AS_MCSTR(body));
+            builder.setHTMLBody(AS_TRANSIENT_MCSTR(body));
         }
     }
 
-    builder.header()->setSubject(AS_MCSTR(draft.subject()));
-    builder.header()->setMessageID(AS_MCSTR(draft.headerMessageId()));
+    builder.header()->setSubject(AS_TRANSIENT_MCSTR(draft.subject()));
+    builder.header()->setMessageID(AS_TRANSIENT_MCSTR(draft.headerMessageId()));
     builder.header()->setUserAgent(MCSTR("Mailspring"));
     builder.header()->setDate(time(0));
     
     // todo: lookup thread reference entire chain?
 
     if (draft.replyToHeaderMessageId() != "") {
-        builder.header()->setReferences(Array::arrayWithObject(AS_MCSTR(draft.replyToHeaderMessageId())));
-        builder.header()->setInReplyTo(Array::arrayWithObject(AS_MCSTR(draft.replyToHeaderMessageId())));
+        builder.header()->setReferences(Array::arrayWithObject(AS_TRANSIENT_MCSTR(draft.replyToHeaderMessageId())));
+        builder.header()->setInReplyTo(Array::arrayWithObject(AS_TRANSIENT_MCSTR(draft.replyToHeaderMessageId())));
     }
     if (draft.forwardedHeaderMessageId() != "") {
-        builder.header()->setReferences(Array::arrayWithObject(AS_MCSTR(draft.forwardedHeaderMessageId())));
+        builder.header()->setReferences(Array::arrayWithObject(AS_TRANSIENT_MCSTR(draft.forwardedHeaderMessageId())));
     }
 
     Array * to = Array::array();
@@ -1534,11 +1772,11 @@ void TaskProcessor::performRemoteSendDraft(Task * task) {
         wstring_convert<codecvt_utf8<wchar_t>, wchar_t> convert;
         Attachment * a = Attachment::attachmentWithContentsOfFile(AS_WIDE_MCSTR(convert.from_bytes(path)));
 #else
-        Attachment * a = Attachment::attachmentWithContentsOfFile(AS_MCSTR(path));
+        Attachment * a = Attachment::attachmentWithContentsOfFile(AS_TRANSIENT_MCSTR(path));
 #endif
 
         if (file.contentId().is_string()) {
-            a->setContentID(AS_MCSTR(file.contentId().get<string>()));
+            a->setContentID(AS_TRANSIENT_MCSTR(file.contentId().get<string>()));
             a->setInlineAttachment(true);
             builder.addRelatedAttachment(a);
         } else {
@@ -1546,6 +1784,12 @@ void TaskProcessor::performRemoteSendDraft(Task * task) {
         }
     }
 
+    // Only the body changes between the per-recipient copies, so encode the
+    // attachments once and reuse them for each copy.
+    if (multisend) {
+        builder.setEncodedAttachmentsCacheEnabled(true);
+    }
+
     // Save the message data / body we'll write to the sent folder
     Data * messageDataForSent = builder.data();
 
@@ -1560,21 +1804,35 @@ void TaskProcessor::performRemoteSendDraft(Task * task) {
     MailUtils::configureSessionForAccount(smtp, account);
     string succeeded;
 
+    // If earlier sends showed that this SMTP gateway doesn't file messages into the sent
+    // folder itself, there's no point polling for a copy afterwards. Instead we append ours
+    // over the IMAP connection while the SMTP connection is still delivering the message.
+    json sentStatus = sent->localStatus();
+    int gatewayMisses = sentStatus.count(LS_SENT_GATEWAY_MISSES) && sentStatus[LS_SENT_GATEWAY_MISSES].is_number() ? sentStatus[LS_SENT_GATEWAY_MISSES].get<int>() : 0;
+    int appendedSends = sentStatus.count(LS_SENT_APPENDED_SENDS) && sentStatus[LS_SENT_APPENDED_SENDS].is_number() ? sentStatus[LS_SENT_APPENDED_SENDS].get<int>() : 0;
+    bool appendWhileSending = !multisend && gatewayMisses >= SENT_GATEWAY_MISSES_BEFORE_APPEND && appendedSends < SENT_APPENDED_SENDS_BEFORE_POLL;
+    bool appendedWhileSending = false;
+    uint32_t sentFolderMessageUID = 0;
+
     if (multisend) {
         logger->info("-- Sending customized message bodies to each recipient:");
 
+        // Deliver every copy over the same SMTP connection.
+        smtp.setConnectionReuseEnabled(true);
+
         for (json::iterator it = perRecipientBodies.begin(); it != perRecipientBodies.end(); ++it) {
             if (it.key() == "self") {
                 continue;
             }
             
+            AutoreleasePool iterationPool;
             logger->info("--- Sending to {}", it.key());
             if (plaintext) {
-                builder.setTextBody(AS_MCSTR(it.value().get<string>()));
+                builder.setTextBody(AS_TRANSIENT_MCSTR(it.value().get<string>()));
             } else {
-                builder.setHTMLBody(AS_MCSTR(it.value().get<string>()));
+                builder.setHTMLBody(AS_TRANSIENT_MCSTR(it.value().get<string>()));
             }
-            Address * to = Address::addressWithMailbox(AS_MCSTR(it.key()));
+            Address * to = Address::addressWithMailbox(AS_TRANSIENT_MCSTR(it.key()));
             Data * messageData = builder.data();
             smtp.sendMessage(builder.header()->from(), Array::arrayWithObject(to), messageData, &sprogress, &err);
             if (err != ErrorNone) {
@@ -1582,12 +1840,46 @@ void TaskProcessor::performRemoteSendDraft(Task * task) {
             }
             succeeded += "\n - " + it.key();
         }
+        smtp.disconnect();
+
+    } else if (appendWhileSending) {
+        logger->info("-- Sending a single message body to all recipients while placing it in the sent folder:");
+        std::thread smtpThread([&]() {
+            AutoreleasePool threadPool;
+            smtp.sendMessage(messageDataForSent, &sprogress, &err);
+        });
+
+        IMAPProgress iprogress;
+        ErrorCode appendErr = ErrorNone;
+        session->appendMessage(sentPath, messageDataForSent, MessageFlagSeen, &iprogress, &sentFolderMessageUID, &appendErr);
+        smtpThread.join();
+
+        if (appendErr != ErrorNone) {
+            logger->error("-X IMAP Error: {}. Could not place a message into the Sent folder, will retry after sending.", ErrorCodeToTypeMap[appendErr]);
+            sentFolderMessageUID = 0;
+        } else {
+            appendedWhileSending = true;
+        }
+
+        if (err != ErrorNone && appendedWhileSending) {
+            // The message was never delivered - don't leave a copy of it in the sent folder.
+            IndexSet * uids = IndexSet::indexSet();
+            if (sentFolderMessageUID != 0) {
+                uids->addIndex(sentFolderMessageUID);
+            } else {
+                session->findUIDsOfRecentHeaderMessageID(sentPath, AS_TRANSIENT_MCSTR(draft.headerMessageId()), uids);
+            }
+            if (uids->count() > 0) {
+                logger->info("-- Removing {} messages placed in the sent folder for the failed send.", uids->count());
+                _removeMessagesResilient(session, store, account->id(), sentPath, uids);
+            }
+        }
 
     } else {
         logger->info("-- Sending a single message body to all recipients:");
         smtp.sendMessage(messageDataForSent, &sprogress, &err);
     }
-    
+
     if (err != ErrorNone) {
         int e = smtp.lastLibetpanError();
         string es = LibEtPanCodeToTypeMap.count(e) ? LibEtPanCodeToTypeMap[e] : to_string(e);
@@ -1615,8 +1907,7 @@ void TaskProcessor::performRemoteSendDraft(Task * task) {
      gateway and clean them up. Some mail servers automatically place messages in the sent
      folder, others don't.
      */
-    uint32_t sentFolderMessageUID = 0;
-    {
+    if (!appendedWhileSending) {
         // grab the last few items in the sent folder... we know we don't need more than 10
         // because multisend is capped.
         int tries = 0;
@@ -1629,7 +1920,7 @@ void TaskProcessor::performRemoteSendDraft(Task * task) {
 				std::this_thread::sleep_for(std::chrono::seconds(delay[tries]));
             }
             tries ++;
-            session->findUIDsOfRecentHeaderMessageID(sentPath, AS_MCSTR(draft.headerMessageId()), uids);
+            session->findUIDsOfRecentHeaderMessageID(sentPath, AS_TRANSIENT_MCSTR(draft.headerMessageId()), uids);
         }
     
         if (multisend && (uids->count() > 0)) {
@@ -1643,7 +1934,7 @@ void TaskProcessor::performRemoteSendDraft(Task * task) {
             auto all = store->find<Folder>(Query().equal("accountId", account->id()).equal("role", "all"));
             if (all != nullptr) {
                 uids->removeAllIndexes();
-                session->findUIDsOfRecentHeaderMessageID(AS_MCSTR(all->path()), AS_MCSTR(draft.headerMessageId()), uids);
+                session->findUIDsOfRecentHeaderMessageID(AS_MCSTR(all->path()), AS_TRANSIENT_MCSTR(draft.headerMessageId()), uids);
                 if (uids->count() > 0) {
                     logger->info("-- Deleting {} messages just moved to {} by the SMTP gateway.", uids->count(), all->path());
                     _removeMessagesResilient(session, store, account->id(), AS_MCSTR(all->path()), uids);
@@ -1663,9 +1954,40 @@ void TaskProcessor::performRemoteSendDraft(Task * task) {
             logger->error("-X IMAP Error: {}. This may result in duplicate messages in the Sent folder.", ErrorCodeToTypeMap[err]);
             err = ErrorNone;
         }
+
+        // Remember whether the gateway filed the message for us. A single miss may just be
+        // a slow gateway, so only consecutive misses switch later sends to appending.
+        if (!multisend) {
+            json initialStatus = sent->localStatus();
+            sent->localStatus()[LS_SENT_GATEWAY_MISSES] = sentFolderMessageUID == 0 ? gatewayMisses + 1 : 0;
+            sent->localStatus()[LS_SENT_APPENDED_SENDS] = 0;
+            store->saveFolderStatus(sent.get(), initialStatus);
+        }
+
+    } else {
+        // We appended our own copy, but check whether the gateway filed one as well. If it
+        // did, keep the gateway's copy, remove ours, and go back to polling on later sends.
+        IndexSet * uids = IndexSet::indexSet();
+        session->findUIDsOfRecentHeaderMessageID(sentPath, AS_TRANSIENT_MCSTR(draft.headerMessageId()), uids);
+        if (sentFolderMessageUID != 0) {
+            uids->removeIndex(sentFolderMessageUID);
+        }
+
+        json initialStatus = sent->localStatus();
+        if (sentFolderMessageUID != 0 && uids->count() > 0) {
+            logger->info("-- The SMTP gateway also placed the message in the sent folder, removing our copy (UID {})", sentFolderMessageUID);
+            _removeMessagesResilient(session, store, account->id(), sentPath, IndexSet::indexSetWithIndex(sentFolderMessageUID));
+            sentFolderMessageUID = (uint32_t)uids->allRanges()[0].location;
+            sent->localStatus()[LS_SENT_GATEWAY_MISSES] = 0;
+            sent->localStatus()[LS_SENT_APPENDED_SENDS] = 0;
+        } else {
+            sent->localStatus()[LS_SENT_APPENDED_SENDS] = appendedSends + 1;
+        }
+        store->saveFolderStatus(sent.get(), initialStatus);
+        err = ErrorNone;
     }
 
-    if (sentFolderMessageUID == 0) {
+    if (sentFolderMessageUID == 0 && !appendedWhileSending) {
         // Manually place a single message in the sent folder
         IMAPProgress iprogress;
         logger->info("-- Placing a new message with `self` body in the sent folder.");
@@ -1721,36 +2043,48 @@ void TaskProcessor::performRemoteSendDraft(Task * task) {
     IMAPMessage * remoteMessage = nullptr;
     
     logger->info("-- Syncing sent message (UID {}) to the local mail store", sentFolderMessageUID);
-    IMAPMessagesRequestKind kind = (IMAPMessagesRequestKind)(IMAPMessagesRequestKindHeaders | IMAPMessagesRequestKindFlags);
+    MessageParser * messageParser = MessageParser::messageParserWithData(messageDataForSent);
+    time_t syncDataTimestamp = time(0);
+
     if (session->storedCapabilities()->containsIndex(IMAPCapabilityGmail)) {
-        kind = (IMAPMessagesRequestKind)(kind | IMAPMessagesRequestKindGmailLabels | IMAPMessagesRequestKindGmailThreadID | IMAPMessagesRequestKindGmailMessageID);
-    }
-    
-    // Important: Courier (and maybe other IMAP servers) won't show us new messages we've created
-    // in the folder unless we re-select the folder. (I think they're treating UIDs like sequence
-    // numbers?). We must re-select the sent folder to pull down the message we created.
-    session->select(sentPath, &err);
+        IMAPMessagesRequestKind kind = (IMAPMessagesRequestKind)(IMAPMessagesRequestKindHeaders | IMAPMessagesRequestKindFlags | IMAPMessagesRequestKindGmailLabels | IMAPMessagesRequestKindGmailThreadID | IMAPMessagesRequestKindGmailMessageID);
 
-    time_t syncDataTimestamp = time(0);
-    IndexSet * uids = IndexSet::indexSetWithIndex(sentFolderMessageUID);
-    Array * remote = session->fetchMessagesByUID(sentPath, kind, uids, nullptr, &err);
+        // Important: Courier (and maybe other IMAP servers) won't show us new messages we've created
+        // in the folder unless we re-select the folder. (I think they're treating UIDs like sequence
+        // numbers?). We must re-select the sent folder to pull down the message we created.
+        session->select(sentPath, &err);
 
-    // Delete the draft. We do this as close as possible to when we write the message in
-    // so there isn't any flicker in the client, but before error checking because we always
-    // want it to always disppear since sending succeeded.
-    store->remove(&draft);
+        IndexSet * uids = IndexSet::indexSetWithIndex(sentFolderMessageUID);
+        Array * remote = session->fetchMessagesByUID(sentPath, kind, uids, nullptr, &err);
 
-    if (err != ErrorNone) {
-        logger->error("-X Error: {} occurred syncing the sent message to the local mail store. Metadata will not be attached.", ErrorCodeToTypeMap[err]);
-        return;
-    }
-    if (remote->count() == 0) {
-        logger->error("-X Error: No messages were returned. Metadata will not be attached!");
-        return;
+        // Delete the draft. We do this as close as possible to when we write the message in
+        // so there isn't any flicker in the client, but before error checking because we always
+        // want it to always disppear since sending succeeded.
+        store->remove(&draft);
+
+        if (err != ErrorNone) {
+            logger->error("-X Error: {} occurred syncing the sent message to the local mail store. Metadata will not be attached.", ErrorCodeToTypeMap[err]);
+            return;
+        }
+        if (remote->count() == 0) {
+            logger->error("-X Error: No messages were returned. Metadata will not be attached!");
+            return;
+        }
+        remoteMessage = (IMAPMessage *)(remote->lastObject());
+
+    } else {
+        // Outside of Gmail there are no labels or thread IDs to pick up, and the headers and
+        // flags are the ones we just sent, so build the message locally instead of fetching it.
+        remoteMessage = new IMAPMessage();
+        remoteMessage->autorelease();
+        remoteMessage->setUid(sentFolderMessageUID);
+        remoteMessage->setFlags(MessageFlagSeen);
+        remoteMessage->setOriginalFlags(MessageFlagSeen);
+        remoteMessage->setSize(messageDataForSent->length());
+        remoteMessage->setHeader(messageParser->header());
+        store->remove(&draft);
     }
 
-    MessageParser * messageParser = MessageParser::messageParserWithData(messageDataForSent);
-    remoteMessage = (IMAPMessage *)(remote->lastObject());
     localMessage = processor.insertFallbackToUpdateMessage(remoteMessage, *sent, syncDataTimestamp);
     if (localMessage == nullptr) {
         logger->error("-X Error: processor.insert did not return a message.");
@@ -1873,21 +2207,17 @@ void TaskProcessor::performRemoteGetMessageRFC2822(Task * task) {
         throw SyncException("not-found", "Message not found for RFC2822 fetch", false);
     }
 
-    Data * data = session->fetchMessageByUID(AS_MCSTR(msg->remoteFolder()["path"].get<string>()), msg->remoteUID(), &cb, &err);
-    if (err != ErrorNone) {
-        logger->error("Unable to fetch rfc2822 for message (UID {}). Error {}", msg->remoteUID(), ErrorCodeToTypeMap[err]);
-        throw SyncException(err, "performRemoteGetMessageRFC2822");
-    }
-    if (data == nullptr) {
-        logger->error("fetchMessageByUID returned null data for message (UID {})", msg->remoteUID());
-        throw SyncException(ErrorFetch, "performRemoteGetMessageRFC2822 - null data");
-    }
 #ifdef _MSC_VER
     wstring_convert<codecvt_utf8<wchar_t>, wchar_t> convert;
-    data->writeToFile(AS_WIDE_MCSTR(convert.from_bytes(filepath)));
+    String * outputFile = AS_WIDE_MCSTR(convert.from_bytes(filepath));
 #else
-    data->writeToFile(AS_MCSTR(filepath));
+    String * outputFile = AS_TRANSIENT_MCSTR(filepath);
 #endif
+    session->fetchMessageToFileByUID(AS_MCSTR(msg->remoteFolder()["path"].get<string>()), msg->remoteUID(), outputFile, &cb, &err);
+    if (err != ErrorNone) {
+        logger->error("Unable to fetch rfc2822 for message (UID {}). Error {}", msg->remoteUID(), ErrorCodeToTypeMap[err]);
+        throw SyncException(err, "performRemoteGetMessageRFC2822");
+    }
     setFileModificationTime(filepath, msg->date());
 }
 
@@ -2028,22 +2358,19 @@ void TaskProcessor::performRemoteGetManyRFC2822(Task * task) {
             ErrorCode err = ErrorNone;
 
             try {
-                Data * data = session->fetchMessageByUID(
-                    AS_MCSTR(folderPath), msg->remoteUID(), &cb, &err);
+#ifdef _MSC_VER
+                wstring_convert<codecvt_utf8<wchar_t>, wchar_t> convert;
+                String * outputFile = AS_WIDE_MCSTR(convert.from_bytes(filepath));
+#else
+                String * outputFile = AS_TRANSIENT_MCSTR(filepath);
+#endif
+                session->fetchMessageToFileByUID(
+                    AS_MCSTR(folderPath), msg->remoteUID(), outputFile, &cb, &err);
 
                 if (err != ErrorNone) {
                     throw SyncException(err, "GetManyRFC2822 fetch");
                 }
-                if (data == nullptr) {
-                    throw SyncException(ErrorFetch, "GetManyRFC2822 - null data");
-                }
 
-#ifdef _MSC_VER
-                wstring_convert<codecvt_utf8<wchar_t>, wchar_t> convert;
-                data->writeToFile(AS_WIDE_MCSTR(convert.from_bytes(filepath)));
-#else
-                data->writeToFile(AS_MCSTR(filepath));
-#endif
                 setFileModificationTime(filepath, msg->date());
                 exported++;
             } catch (SyncException & ex) {
@@ -2215,20 +2542,20 @@ void TaskProcessor::performRemoteSendRSVP(Task * task) {
     string boundary = "----=_Mailspring_RSVP_" + to_string(time(0)) + "_" + to_string(rand());
 
     // Base64 encode the ICS data (RFC 6047 recommends base64 for maximum compatibility)
-    Data * icsData = AS_MCSTR(ics)->dataUsingEncoding("utf-8");
+    Data * icsData = AS_TRANSIENT_MCSTR(ics)->dataUsingEncoding("utf-8");
     String * icsBase64 = icsData->base64String();
 
     // Build MIME headers
     MessageBuilder builder;
-    builder.header()->setSubject(AS_MCSTR(subject));
+    builder.header()->setSubject(AS_TRANSIENT_MCSTR(subject));
     builder.header()->setUserAgent(MCSTR("Mailspring"));
     builder.header()->setDate(time(0));
 
     Array * toArray = Array::array();
-    toArray->addObject(Address::addressWithMailbox(AS_MCSTR(organizer)));
+    toArray->addObject(Address::addressWithMailbox(AS_TRANSIENT_MCSTR(organizer)));
     builder.header()->setTo(toArray);
 
-    Address * me = Address::addressWithMailbox(AS_MCSTR(fromEmail));
+    Address * me = Address::addressWithMailbox(AS_TRANSIENT_MCSTR(fromEmail));
     builder.header()->setFrom(me);
     builder.header()->setReplyTo(Array::arrayWithObject(me));
 
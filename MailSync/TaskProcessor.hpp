@@ -48,6 +48,7 @@ public:
     
     void performLocal(Task * task);
     void performRemote(Task * task);
+    void performRemoteTasks(vector<shared_ptr<Task>> & tasks);
     void cancel(string taskId);
     
 private:
@@ -57,6 +58,7 @@ private:
 
     void performLocalChangeOnMessages(Task * task,  void (*modifyLocalMessage)(Message *, json &));
     void performRemoteChangeOnMessages(Task * task, bool updatesFolder, void (*applyInFolder)(IMAPSession * session, String * path, IndexSet * uids, vector<shared_ptr<Message>> messages, json & data));
+    void performRemoteCoalescedChangeOnMessages(vector<Task *> tasks, string kind);
     void performLocalSaveDraft(Task * task);
     void performLocalDestroyDraft(Task * task);
     void performRemoteDestroyDraft(Task * task);
@@ -28,7 +28,7 @@ VCardProperty::VCardProperty(string name, string value, string attrs):
 {
 }
 
-VCardProperty::VCardProperty(string line)
+VCardProperty::VCardProperty(const string & line)
 {
     size_t colon = line.find(":");
     size_t semicolon = line.find(";");
@@ -45,7 +45,7 @@ VCardProperty::VCardProperty(string line)
     }
 }
 
-string VCardProperty::getName() {
+const string & VCardProperty::getName() {
     return _name;
 }
 
@@ -53,7 +53,7 @@ void VCardProperty::setName(string name) {
     _name = name;
 }
 
-string VCardProperty::getValue() {
+const string & VCardProperty::getValue() {
     return _value;
 }
 
@@ -70,10 +70,7 @@ string VCardProperty::serialize() {
 }
 
 
-VCard::VCard(string vcf) {
-    vcf = vcf + "\r\n";
-    
-    auto split = vcf.find("\n");
+VCard::VCard(const string & vcf) {
     string unparsed = "";
     
     // A Vcard is mostly one-property per line but lines can be "run-on", in which case
@@ -90,40 +87,42 @@ VCard::VCard(string vcf) {
      REV:2019-10-11T20:03:16Z
      */
     
-    while (split != string::npos) {
-        string line = vcf.substr(0, split);
-        if (line.size()) {
-            // Note: We split based on "\n" but the official format calls for "\r\n", so we check
-            // and optionally remove the \r if it's present on eacch line.
-            if (line.substr(split - 1) == "\r") {
-                line = line.substr(0, split - 1);
-            }
-            if (line.size()) {
-                if (line.substr(0, 1) == " ") {
-                    unparsed += line.substr(1);
-                } else {
-                    if (unparsed != "") {
-                        auto prop = make_shared<VCardProperty>(unparsed);
-                        if (prop->getName() != "BEGIN" && prop->getName() != "END") {
-                            _properties.push_back(prop);
-                        }
-                    }
-                    unparsed = line;
+    size_t start = 0;
+    while (start < vcf.size()) {
+        size_t split = vcf.find('\n', start);
+        size_t end = split == string::npos ? vcf.size() : split;
+
+        // Note: We split based on "\n" but the official format calls for "\r\n", so we check
+        // and optionally remove the \r if it's present on each line.
+        size_t lineEnd = (end > start && vcf[end - 1] == '\r') ? end - 1 : end;
+
+        if (lineEnd > start) {
+            if (vcf[start] == ' ') {
+                unparsed.append(vcf, start + 1, lineEnd - start - 1);
+            } else {
+                if (unparsed != "") {
+                    appendParsedLine(unparsed);
                 }
+                unparsed.assign(vcf, start, lineEnd - start);
             }
         }
 
-        vcf = vcf.substr(split + 1);
-        split = vcf.find("\n");
+        if (split == string::npos) {
+            break;
+        }
+        start = split + 1;
     }
     
     if (unparsed != "") {
-        auto prop = make_shared<VCardProperty>(unparsed);
-        if (prop->getName() != "BEGIN" && prop->getName() != "END") {
-            _properties.push_back(prop);
-        }
+        appendParsedLine(unparsed);
     }
+}
 
+void VCard::appendParsedLine(const string & line) {
+    VCardProperty prop{line};
+    if (prop.getName() != "BEGIN" && prop.getName() != "END") {
+        _properties.push_back(std::move(prop));
+    }
 }
 
 bool VCard::incomplete() {
@@ -135,27 +134,27 @@ bool VCard::incomplete() {
 // These getters add a property with a blank value if no matching properties
 // are found, and the new property can be mutated. This is for consistency with Belcard.
 
-shared_ptr<VCardProperty> VCard::getUniqueId() {
+VCardProperty * VCard::getUniqueId() {
     return propertiesWithName("UID", true).front();
 }
 
-shared_ptr<VCardProperty> VCard::getVersion() {
+VCardProperty * VCard::getVersion() {
     return propertiesWithName("VERSION", true).front();
 }
 
-vector<shared_ptr<VCardProperty>> VCard::getEmails() {
+vector<VCardProperty *> VCard::getEmails() {
     return propertiesWithName("EMAIL", true);
 
 }
-shared_ptr<VCardProperty> VCard::getFormattedName() {
+VCardProperty * VCard::getFormattedName() {
     return propertiesWithName("FN", true).front();
 
 }
-shared_ptr<VCardProperty> VCard::getKind() {
+VCardProperty * VCard::getKind() {
     return propertiesWithName("KIND", true).front();
 }
 
-shared_ptr<VCardProperty> VCard::getName() {
+VCardProperty * VCard::getName() {
     return propertiesWithName("N", true).front();
 }
 
@@ -163,42 +162,42 @@ void VCard::setName(string name) {
     propertiesWithName("N", true).front()->setValue(name);
 }
 
-void VCard::addProperty(shared_ptr<VCardProperty> prop) {
-    _properties.push_back(prop);
+VCardProperty * VCard::addProperty(VCardProperty prop) {
+    _properties.push_back(std::move(prop));
+    return &_properties.back();
 }
 
-void VCard::removeProperty(shared_ptr<VCardProperty> prop) {
-    auto idx = std::find(_properties.begin(), _properties.end(), prop);
-    if (idx != _properties.end()) {
-        _properties.erase(idx);
-    }
+void VCard::removeProperty(VCardProperty * prop) {
+    // Erasing from the middle of the deque would invalidate pointers held by the
+    // caller, so we blank the property instead. Properties without a name are
+    // never matched, and properties without a value are not serialized.
+    prop->setName("");
+    prop->setValue("");
 }
 
-vector<shared_ptr<VCardProperty>> VCard::getMembers() {
+vector<VCardProperty *> VCard::getMembers() {
     return propertiesWithName("MEMBER");
 }
 
-vector<shared_ptr<VCardProperty>> VCard::getExtendedProperties() {
-    vector<shared_ptr<VCardProperty>> results {};
-    for (auto prop : _properties) {
-        if (prop->getName().substr(0, 2) == "X-") {
-            results.push_back(prop);
+vector<VCardProperty *> VCard::getExtendedProperties() {
+    vector<VCardProperty *> results {};
+    for (auto & prop : _properties) {
+        if (prop.getName().compare(0, 2, "X-") == 0) {
+            results.push_back(&prop);
         }
     }
     return results;
 }
 
-vector<shared_ptr<VCardProperty>> VCard::propertiesWithName(string name, bool createIfEmpty) {
-    vector<shared_ptr<VCardProperty>> results {};
-    for (auto prop : _properties) {
-        if (prop->getName() == name) {
-            results.push_back(prop);
+vector<VCardProperty *> VCard::propertiesWithName(const string & name, bool createIfEmpty) {
+    vector<VCardProperty *> results {};
+    for (auto & prop : _properties) {
+        if (prop.getName() == name) {
+            results.push_back(&prop);
         }
     }
     if (createIfEmpty && results.size() == 0) {
-        shared_ptr<VCardProperty> added = make_shared<VCardProperty>(name, "");
-        results.push_back(added);
-        _properties.push_back(added);
+        results.push_back(addProperty(VCardProperty(name, "")));
     }
     
     return results;
@@ -207,12 +206,12 @@ vector<shared_ptr<VCardProperty>> VCard::propertiesWithName(string name, bool cr
 string VCard::serialize() {
     stringstream str;
     str << "BEGIN:VCARD\r\n";
-    for (auto prop : _properties) {
-        if (prop->getValue() == "") {
+    for (auto & prop : _properties) {
+        if (prop.getValue() == "") {
             // ignore properties we createIfEmpty but don't fill
             continue;
         }
-        str << prop->serialize();
+        str << prop.serialize();
         str << "\r\n";
     }
     str << "END:VCARD\r\n";
@@ -10,6 +10,7 @@
 #ifndef VCard_hpp
 #define VCard_hpp
 
+#include <deque>
 #include <vector>
 #include <memory>
 #include <string>
@@ -24,42 +25,48 @@ class VCardProperty
     
     public:
     VCardProperty(string name, string value, string attrs = "");
-    VCardProperty(string line);
+    VCardProperty(const string & line);
 
-    string getName();
+    const string & getName();
     void setName(string name);
-    string getValue();
+    const string & getValue();
     void setValue(string value);
     string serialize();
 };
 
+/**
+ Properties are stored by value. A deque is used so that appending properties
+ never moves existing ones, and the raw pointers returned by the accessors
+ below remain valid for the lifetime of the card.
+ */
 class VCard
 {
-    vector<shared_ptr<VCardProperty>> _properties;
+    deque<VCardProperty> _properties;
 public:
-    explicit VCard(string vcf);
+    explicit VCard(const string & vcf);
     
     bool incomplete();
 
-    shared_ptr<VCardProperty> getUniqueId();
-    shared_ptr<VCardProperty> getVersion();
-    vector<shared_ptr<VCardProperty>> getEmails();
-    shared_ptr<VCardProperty> getFormattedName();
-    shared_ptr<VCardProperty> getKind();
+    VCardProperty * getUniqueId();
+    VCardProperty * getVersion();
+    vector<VCardProperty *> getEmails();
+    VCardProperty * getFormattedName();
+    VCardProperty * getKind();
 
-    shared_ptr<VCardProperty> getName();
+    VCardProperty * getName();
     void setName(string name);
     
-    vector<shared_ptr<VCardProperty>> getMembers();
+    vector<VCardProperty *> getMembers();
 
-    vector<shared_ptr<VCardProperty>> getExtendedProperties();
-    void addProperty(shared_ptr<VCardProperty> prop);
-    void removeProperty(shared_ptr<VCardProperty> prop);
+    vector<VCardProperty *> getExtendedProperties();
+    VCardProperty * addProperty(VCardProperty prop);
+    void removeProperty(VCardProperty * prop);
     
     string serialize();
 
 protected:
-    vector<shared_ptr<VCardProperty>> propertiesWithName(string name, bool createIfEmpty = false);
+    void appendParsedLine(const string & line);
+    vector<VCardProperty *> propertiesWithName(const string & name, bool createIfEmpty = false);
 };
 
 #endif
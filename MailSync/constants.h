@@ -14,7 +14,10 @@
 #ifndef constants_h
 #define constants_h
 
-#define AS_MCSTR(X)         mailcore::String::uniquedStringWithUTF8Characters(X.c_str())
+// Folder paths, label names and other values that repeat for the life of the process.
+#define AS_MCSTR(X)         MailUtils::internedString(X)
+// Per-call values (file paths, bodies, addresses). Requires an AutoreleasePool.
+#define AS_TRANSIENT_MCSTR(X) mailcore::String::stringWithUTF8Characters((X).c_str())
 #ifdef _MSC_VER
 // On Windows with newer ICU, UChar is char16_t not wchar_t, so we need reinterpret_cast
 #define AS_WIDE_MCSTR(X)    mailcore::String::stringWithCharacters(reinterpret_cast<const UChar*>(X.c_str()))
@@ -224,6 +227,13 @@ static vector<string> V9_SETUP_QUERIES = {
     "CREATE INDEX IF NOT EXISTS EventRecurrenceId ON Event(calendarId, icsuid, recurrenceId)",
 };
 
+// V10: Index Google contacts by resource name so sync doesn't load them all into memory
+static vector<string> V10_SETUP_QUERIES = {
+    "ALTER TABLE `Contact` ADD COLUMN grn VARCHAR(255)",
+    "UPDATE `Contact` SET grn = json_extract(data, '$.grn') WHERE source = 'gpeople'",
+    "CREATE INDEX IF NOT EXISTS ContactGoogleResourceIndex ON Contact(accountId, grn) WHERE grn IS NOT NULL",
+};
+
 static map<string, string> COMMON_FOLDER_NAMES = {
     {"gel\xc3\xb6scht", "trash"},
     {"papierkorb", "trash"},
@@ -41,6 +41,7 @@
 #include "SyncException.hpp"
 #include "Task.hpp"
 #include "TaskProcessor.hpp"
+#include "LocalTaskQueue.hpp"
 #include "NetworkRequestUtils.hpp"
 #include "ThreadUtils.h"
 #include "constants.h"
@@ -72,6 +73,11 @@ std::thread * bgThread = nullptr;
 std::thread * calContactsThread = nullptr;
 std::thread * metadataThread = nullptr;
 std::thread * metadataExpirationThread = nullptr;
+vector<std::thread *> pushThreads;
+
+// Folders other than the inbox that get their own IDLE connection. Kept small because
+// every entry costs a connection and servers cap how many an account may open.
+vector<string> pushFolderRoles {"sent", "drafts"};
 
 
 class AccumulatorLogger : public ConnectionLogger {
@@ -164,6 +170,28 @@ void runForegroundSyncWorker() {
     }
 }
 
+void runPushSyncWorker(shared_ptr<SyncWorker> worker, string role) {
+    while(true) {
+        try {
+            worker->configure();
+            if (!worker->pushCycleIteration(role)) {
+                spdlog::get("logger")->info("Push worker for {} exiting.", role);
+                return;
+            }
+        } catch (SyncException & ex) {
+            exceptions::logCurrentExceptionWithStackTrace();
+            if (!ex.isRetryable()) {
+                return;
+            }
+            spdlog::get("logger")->info("--sleeping");
+            MailUtils::sleepWorkerUntilWakeOrSec(120);
+        } catch (...) {
+            exceptions::logCurrentExceptionWithStackTrace();
+            abort();
+        }
+    }
+}
+
 void runBackgroundSyncWorker() {
     bool started = false;
     
@@ -196,6 +224,14 @@ void runBackgroundSyncWorker() {
                         runForegroundSyncWorker();
                     });
                 }
+                if (pushThreads.empty()) {
+                    for (string & role : pushFolderRoles) {
+                        pushThreads.push_back(new std::thread([role]() {
+                            SetThreadName(("push-" + role).c_str());
+                            runPushSyncWorker(make_shared<SyncWorker>(bgWorker->account), role);
+                        }));
+                    }
+                }
 
                 started = true;
             }
@@ -221,7 +257,7 @@ void runBackgroundSyncWorker() {
             exceptions::logCurrentExceptionWithStackTrace();
             abort();
         }
-        MailUtils::sleepWorkerUntilWakeOrSec(120);
+        MailUtils::sleepWorkerUntilWakeOrSec(bgWorker->secondsUntilNextSync());
     }
 }
 
@@ -292,7 +328,7 @@ int runTestAuth(shared_ptr<Account> account) {
     SMTPSession smtp;
     Array * folders;
     ErrorCode err = ErrorNone;
-    Address * from = Address::addressWithMailbox(AS_MCSTR(account->emailAddress()));
+    Address * from = Address::addressWithMailbox(AS_TRANSIENT_MCSTR(account->emailAddress()));
     string errorService = "imap";
     string containerFolderPath = account->containerFolder();
     string mainPrefix = "";
@@ -609,16 +645,36 @@ int runInstallCheck() {
     return success ? 0 : 1;
 }
 
-void runListenOnMainThread(shared_ptr<Account> account) {
-    MailStore store;
-    TaskProcessor processor{account, &store, nullptr};
+void wakeForegroundWorkerForTask() {
+    // interrupt the foreground sync worker to do the remote part of the task. We wait a short time
+    // because we want tasks queued back to back to run ASAP and not fight for locks with remote
+    // syncback. This also mitigates any potential remote loads+saves that aren't inside transactions
+    // and could overwrite local changes.
+    static atomic<bool> queuedForegroundWake { false };
+    bool expected = false;
+    if (queuedForegroundWake.compare_exchange_strong(expected, true)) {
+        std::thread([]() {
+            std::this_thread::sleep_for(chrono::milliseconds(300));
+            if (fgWorker) {
+                fgWorker->idleInterrupt();
+            }
+            queuedForegroundWake = false;
+        }).detach();
+    }
+}
 
-    store.setStreamDelay(5);
+void runListenOnMainThread(shared_ptr<Account> account) {
+    // Tasks are applied to the database on a separate thread, so a large task doesn't
+    // stop us from reading and handling the packets that follow it.
+    LocalTaskQueue localTasks{account, wakeForegroundWorkerForTask};
+    std::thread localTasksThread([&]() {
+        SetThreadName("local-tasks");
+        localTasks.run();
+    });
+    localTasksThread.detach();
 
     time_t lostCINAt = 0;
 
-    processor.cleanupTasksAfterLaunch();
-    
     while(true) {
         AutoreleasePool pool;
         json packet = {};
@@ -651,32 +707,8 @@ void runListenOnMainThread(shared_ptr<Account> account) {
         try {
             string type = packet.count("type") ? packet["type"].get<string>() : "";
 
-            if (type == "queue-task") {
-                packet["task"]["v"] = 0;
-                Task task{packet["task"]};
-                processor.performLocal(&task);
-        
-                // interrupt the foreground sync worker to do the remote part of the task. We wait a short time
-                // because we want tasks queued back to back to run ASAP and not fight for locks with remote
-                // syncback. This also mitigates any potential remote loads+saves that aren't inside transactions
-                // and could overwrite local changes.
-                static atomic<bool> queuedForegroundWake { false };
-                bool expected = false;
-                if (queuedForegroundWake.compare_exchange_strong(expected, true)) {
-                    std::thread([]() {
-                        std::this_thread::sleep_for(chrono::milliseconds(300));
-                        if (fgWorker) {
-                            fgWorker->idleInterrupt();
-                        }
-                        queuedForegroundWake = false;
-                    }).detach();
-                }
-            }
-            
-            if (type == "cancel-task") {
-                // we can't always dequeue a task (if it's started already or potentially even finished).
-                // but if we're deleting a draft we want to dequeue saves, etc.
-                processor.cancel(packet["taskId"].get<string>());
+            if (type == "queue-task" || type == "cancel-task") {
+                localTasks.enqueue(type, packet);
             }
             
             if (type == "wake-workers") {
@@ -705,6 +737,16 @@ void runListenOnMainThread(shared_ptr<Account> account) {
                 if (fgWorker) fgWorker->idleInterrupt();
             }
 
+            if (type == "focus-folders") {
+                // the client is showing these folders - sync them more often for a while
+                vector<string> ids{};
+                for (auto id : packet["folderIds"]) {
+                    ids.push_back(id.get<string>());
+                }
+                if (bgWorker) bgWorker->focusFolders(ids);
+                MailUtils::wakeAllWorkers();
+            }
+
             if (type == "sync-calendar") {
                 static atomic<bool> runningCalendarSync { false };
                 bool expected = false;
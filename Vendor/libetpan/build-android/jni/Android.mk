@@ -11,6 +11,7 @@ endif
 
 src_files = \
 ./src/data-types/base64.c \
+./src/data-types/carena.c \
 ./src/data-types/carray.c \
 ./src/data-types/charconv.c \
 ./src/data-types/chash.c \
@@ -80,6 +81,7 @@ src_files = \
 ./src/low-level/imap/xgmmsgid.c \
 ./src/low-level/imap/xgmthrid.c \
 ./src/low-level/imap/xlist.c \
+./src/low-level/imap/liststatus.c \
 ./src/low-level/imf/mailimf.c \
 ./src/low-level/imf/mailimf_types.c \
 ./src/low-level/imf/mailimf_types_helper.c \
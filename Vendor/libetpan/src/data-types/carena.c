@@ -0,0 +1,247 @@
+/*
+ * libEtPan! -- a mail stuff library
+ *
+ * Copyright (C) 2001, 2005 - DINH Viet Hoa
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the libEtPan! project nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include <stdlib.h>
+#ifndef LIBETPAN_CONFIG_H
+#	include "libetpan-config.h"
+#endif
+
+#include "carena.h"
+
+#if defined(_MSC_VER)
+#	define CARENA_THREAD_LOCAL __declspec(thread)
+#else
+#	define CARENA_THREAD_LOCAL __thread
+#endif
+
+#define CARENA_ALIGNMENT 16
+#define CARENA_ALIGN(size) (((size) + CARENA_ALIGNMENT - 1) & ~((size_t) CARENA_ALIGNMENT - 1))
+
+struct carena_chunk {
+  struct carena_chunk * next;
+  char * begin;
+  char * end;
+};
+
+struct carena_s {
+  struct carena_chunk * chunks;
+  char * cur;
+  size_t chunk_size;
+  int allocating;
+  struct carena_stats stats;
+};
+
+static CARENA_THREAD_LOCAL carena * current_arena = NULL;
+
+static struct carena_chunk * chunk_new(size_t size)
+{
+  struct carena_chunk * chunk;
+  
+  chunk = malloc(CARENA_ALIGN(sizeof(* chunk)) + size);
+  if (chunk == NULL)
+    return NULL;
+  
+  chunk->next = NULL;
+  chunk->begin = (char *) chunk + CARENA_ALIGN(sizeof(* chunk));
+  chunk->end = chunk->begin + size;
+  
+  return chunk;
+}
+
+carena * carena_new(size_t chunk_size)
+{
+  carena * arena;
+  
+  arena = malloc(sizeof(* arena));
+  if (arena == NULL)
+    return NULL;
+  
+  arena->chunks = NULL;
+  arena->cur = NULL;
+  arena->chunk_size = CARENA_ALIGN(chunk_size);
+  arena->allocating = 0;
+  arena->stats.arena_allocations = 0;
+  arena->stats.chunk_allocations = 0;
+  arena->stats.resets = 0;
+  
+  return arena;
+}
+
+static void free_chunks(struct carena_chunk * chunk)
+{
+  while (chunk != NULL) {
+    struct carena_chunk * next;
+    
+    next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+}
+
+void carena_free(carena * arena)
+{
+  if (current_arena == arena)
+    current_arena = NULL;
+  free_chunks(arena->chunks);
+  free(arena);
+}
+
+void * carena_alloc(carena * arena, size_t size)
+{
+  struct carena_chunk * chunk;
+  char * result;
+  
+  size = CARENA_ALIGN(size);
+  
+  if ((arena->chunks == NULL) || ((size_t) (arena->chunks->end - arena->cur) < size)) {
+    /* oversized requests get a chunk of their own */
+    chunk = chunk_new(size > arena->chunk_size ? size : arena->chunk_size);
+    if (chunk == NULL)
+      return NULL;
+    chunk->next = arena->chunks;
+    arena->chunks = chunk;
+    arena->cur = chunk->begin;
+    arena->stats.chunk_allocations ++;
+  }
+  
+  result = arena->cur;
+  arena->cur += size;
+  arena->stats.arena_allocations ++;
+  
+  return result;
+}
+
+void carena_reset(carena * arena)
+{
+  struct carena_chunk * chunk;
+  struct carena_chunk * first;
+  
+  if (arena->chunks == NULL)
+    return;
+  
+  /* keep the oldest chunk, which has the standard size */
+  first = arena->chunks;
+  while (first->next != NULL)
+    first = first->next;
+  
+  chunk = arena->chunks;
+  while (chunk != first) {
+    struct carena_chunk * next;
+    
+    next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+  
+  arena->chunks = first;
+  arena->cur = first->begin;
+  if ((size_t) (first->end - first->begin) > arena->chunk_size) {
+    /* an oversized first chunk is not worth keeping around */
+    free(first);
+    arena->chunks = NULL;
+    arena->cur = NULL;
+  }
+  arena->stats.resets ++;
+}
+
+int carena_owns(carena * arena, const void * ptr)
+{
+  struct carena_chunk * chunk;
+  const char * p;
+  
+  p = ptr;
+  for(chunk = arena->chunks ; chunk != NULL ; chunk = chunk->next) {
+    if ((p >= chunk->begin) && (p < chunk->end))
+      return 1;
+  }
+  
+  return 0;
+}
+
+void carena_get_stats(carena * arena, struct carena_stats * stats)
+{
+  * stats = arena->stats;
+}
+
+carena * carena_set_current(carena * arena)
+{
+  carena * previous;
+  
+  previous = current_arena;
+  current_arena = arena;
+  
+  return previous;
+}
+
+carena * carena_get_current(void)
+{
+  return current_arena;
+}
+
+int carena_set_allocating(carena * arena, int allocating)
+{
+  int previous;
+  
+  previous = arena->allocating;
+  arena->allocating = allocating;
+  
+  return previous;
+}
+
+void * carena_malloc(size_t size)
+{
+  carena * arena;
+  
+  arena = current_arena;
+  if ((arena != NULL) && arena->allocating)
+    return carena_alloc(arena, size);
+  
+  return malloc(size);
+}
+
+void carena_release(void * ptr)
+{
+  carena * arena;
+  
+  if (ptr == NULL)
+    return;
+  
+  arena = current_arena;
+  if ((arena != NULL) && carena_owns(arena, ptr))
+    return;
+  
+  free(ptr);
+}
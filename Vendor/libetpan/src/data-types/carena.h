@@ -0,0 +1,108 @@
+/*
+ * libEtPan! -- a mail stuff library
+ *
+ * Copyright (C) 2001, 2005 - DINH Viet Hoa
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the libEtPan! project nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+#ifndef CARENA_H
+#define CARENA_H
+
+#ifndef LIBETPAN_CONFIG_H
+#       include <libetpan/libetpan-config.h>
+#endif
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+  carena - chunked bump allocator.
+
+  Objects are carved out of large chunks and released all at once by
+  carena_reset(). An arena can be made the current arena of a thread; while
+  it is current and allocating, carena_malloc() serves from it, and
+  carena_release() ignores the pointers it owns so that the usual
+  *_free() functions can run unchanged over an arena-built tree.
+*/
+
+typedef struct carena_s carena;
+
+struct carena_stats {
+  unsigned long arena_allocations; /* allocations served from chunks */
+  unsigned long chunk_allocations; /* malloc() calls made for chunks */
+  unsigned long resets;
+};
+
+LIBETPAN_EXPORT
+carena * carena_new(size_t chunk_size);
+
+LIBETPAN_EXPORT
+void carena_free(carena * arena);
+
+LIBETPAN_EXPORT
+void * carena_alloc(carena * arena, size_t size);
+
+/* Releases every allocation at once. The first chunk is kept for reuse. */
+LIBETPAN_EXPORT
+void carena_reset(carena * arena);
+
+LIBETPAN_EXPORT
+int carena_owns(carena * arena, const void * ptr);
+
+LIBETPAN_EXPORT
+void carena_get_stats(carena * arena, struct carena_stats * stats);
+
+/* Sets the current arena of the calling thread and returns the previous one. */
+LIBETPAN_EXPORT
+carena * carena_set_current(carena * arena);
+
+LIBETPAN_EXPORT
+carena * carena_get_current(void);
+
+/* Enables or disables allocation from the arena while it is current.
+   Returns the previous setting. */
+LIBETPAN_EXPORT
+int carena_set_allocating(carena * arena, int allocating);
+
+/* malloc() replacement: allocates from the current arena when it is
+   allocating, from the heap otherwise. */
+LIBETPAN_EXPORT
+void * carena_malloc(size_t size);
+
+/* free() replacement: does nothing for pointers owned by the current arena. */
+LIBETPAN_EXPORT
+void carena_release(void * ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
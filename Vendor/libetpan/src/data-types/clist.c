@@ -46,11 +46,12 @@
 #endif
 
 #include "clist.h"
+#include "carena.h"
 
 clist * clist_new(void) {
   clist * lst;
   
-  lst = (clist *) malloc(sizeof(clist));
+  lst = (clist *) carena_malloc(sizeof(clist));
   if (!lst) return NULL;
   
   lst->first = lst->last = NULL;
@@ -65,11 +66,11 @@ void clist_free(clist * lst) {
   l1 = lst->first;
   while (l1) {
     l2 = l1->next;
-    free(l1);
+    carena_release(l1);
     l1 = l2;
   }
 
-  free(lst);
+  carena_release(lst);
 }
 
 #ifdef NO_MACROS
@@ -122,7 +123,7 @@ int clist_append(clist * lst, void * data) {
 int clist_insert_before(clist * lst, clistiter * iter, void * data) {
   clistcell * c;
 
-  c = (clistcell *) malloc(sizeof(clistcell));
+  c = (clistcell *) carena_malloc(sizeof(clistcell));
   if (!c) return -1;
 
   c->data = data;
@@ -156,7 +157,7 @@ int clist_insert_before(clist * lst, clistiter * iter, void * data) {
 int clist_insert_after(clist * lst, clistiter * iter, void * data) {
   clistcell * c;
 
-  c = (clistcell *) malloc(sizeof(clistcell));
+  c = (clistcell *) carena_malloc(sizeof(clistcell));
   if (!c) return -1;
 
   c->data = data;
@@ -205,7 +206,7 @@ clistiter * clist_delete(clist * lst, clistiter * iter) {
     ret = NULL;
   }
 
-  free(iter);
+  carena_release(iter);
   lst->count--;
   
   return ret;
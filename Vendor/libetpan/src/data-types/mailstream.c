@@ -53,6 +53,14 @@
 
 #define DEFAULT_NETWORK_TIMEOUT 300
 
+/* The read buffer starts at the size given to mailstream_new() and doubles
+   each time a read fills it, up to this size. */
+#define MAX_READ_BUFFER_SIZE (256 * 1024)
+
+/* Reads at least this large bypass the read buffer and go straight into
+   the caller's memory (typically a literal's MMAPString). */
+#define DIRECT_READ_MIN_SIZE (16 * 1024)
+
 struct timeval mailstream_network_delay =
 {  DEFAULT_NETWORK_TIMEOUT, 0 };
 
@@ -65,10 +73,12 @@ mailstream * mailstream_new(mailstream_low * low, size_t buffer_size)
   if (s == NULL)
     goto err;
 
-  s->read_buffer = malloc(buffer_size);
-  if (s->read_buffer == NULL)
+  s->read_buffer_base = malloc(buffer_size);
+  if (s->read_buffer_base == NULL)
     goto free_s;
+  s->read_buffer = s->read_buffer_base;
   s->read_buffer_len = 0;
+  s->read_buffer_size = buffer_size;
 
   s->write_buffer = malloc(buffer_size);
   if (s->write_buffer == NULL)
@@ -89,7 +99,7 @@ mailstream * mailstream_new(mailstream_low * low, size_t buffer_size)
   return s;
 
  free_read_buffer:
-  free(s->read_buffer);
+  free(s->read_buffer_base);
  free_s:
   free(s);
  err:
@@ -191,12 +201,47 @@ static ssize_t read_from_internal_buffer(mailstream * s,
 
   s->read_buffer_len -= count;
   if (s->read_buffer_len != 0)
-    memmove(s->read_buffer, s->read_buffer + count,
-	    s->read_buffer_len);
+    s->read_buffer += count;
+  else
+    s->read_buffer = s->read_buffer_base;
 
   return count;
 }
 
+/* Must only be called when the read buffer is empty. */
+static ssize_t fill_internal_buffer(mailstream * s)
+{
+  ssize_t read_bytes;
+
+  read_bytes = mailstream_low_read(s->low, s->read_buffer_base,
+                                   s->read_buffer_size);
+  if (read_bytes < 0)
+    return -1;
+
+  s->read_buffer = s->read_buffer_base;
+  s->read_buffer_len = read_bytes;
+
+  /* A full buffer means the peer is sending faster than we drain it:
+     read more per call next time. */
+  if (((size_t) read_bytes == s->read_buffer_size) &&
+      (s->read_buffer_size < MAX_READ_BUFFER_SIZE)) {
+    size_t new_size;
+    char * new_base;
+
+    new_size = s->read_buffer_size * 2;
+    if (new_size > MAX_READ_BUFFER_SIZE)
+      new_size = MAX_READ_BUFFER_SIZE;
+    new_base = realloc(s->read_buffer_base, new_size);
+    if (new_base != NULL) {
+      s->read_buffer_base = new_base;
+      s->read_buffer = new_base;
+      s->read_buffer_size = new_size;
+    }
+  }
+
+  return read_bytes;
+}
+
 LIBETPAN_EXPORT
 ssize_t mailstream_read(mailstream * s, void * buf, size_t count)
 {
@@ -217,7 +262,7 @@ ssize_t mailstream_read(mailstream * s, void * buf, size_t count)
     return read_bytes;
   }
 
-  if (left > s->buffer_max_size) {
+  if ((left > s->read_buffer_size) || (left >= DIRECT_READ_MIN_SIZE)) {
     read_bytes = mailstream_low_read(s->low, cur_buf, left);
 
     if (read_bytes == -1) {
@@ -234,7 +279,7 @@ ssize_t mailstream_read(mailstream * s, void * buf, size_t count)
     return count - left;
   }
 
-  read_bytes = mailstream_low_read(s->low, s->read_buffer, s->buffer_max_size);
+  read_bytes = fill_internal_buffer(s);
   if (read_bytes < 0) {
     if (left == count)
       return -1;
@@ -242,8 +287,6 @@ ssize_t mailstream_read(mailstream * s, void * buf, size_t count)
       return count - left;
     }
   }
-  else
-    s->read_buffer_len += read_bytes;
 
   read_bytes = read_from_internal_buffer(s, cur_buf, left);
   cur_buf += read_bytes;
@@ -284,7 +327,7 @@ int mailstream_close(mailstream * s)
   mailstream_low_close(s->low);
   mailstream_low_free(s->low);
   
-  free(s->read_buffer);
+  free(s->read_buffer_base);
   free(s->write_buffer);
   
   free(s);
@@ -301,11 +344,9 @@ ssize_t mailstream_feed_read_buffer(mailstream * s)
     return -1;
 
   if (s->read_buffer_len == 0) {
-    read_bytes = mailstream_low_read(s->low, s->read_buffer,
-				     s->buffer_max_size);
+    read_bytes = fill_internal_buffer(s);
     if (read_bytes < 0)
       return -1;
-    s->read_buffer_len += read_bytes;
   }
 
   return s->read_buffer_len;
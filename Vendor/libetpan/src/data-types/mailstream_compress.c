@@ -49,7 +49,7 @@
 #include "mailstream_low.h"
 #include "mailstream_cancel.h"
 
-#define CHUNK_SIZE 1024
+#define CHUNK_SIZE (16 * 1024)
 
 #ifndef MIN
 #define MIN(x, y) ((x) < (y) ? (x) : (y))
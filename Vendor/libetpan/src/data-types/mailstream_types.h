@@ -77,8 +77,13 @@ struct _mailstream {
   char * write_buffer;
   size_t write_buffer_len;
 
+  /* read_buffer points at the unread data, which starts somewhere in
+     read_buffer_base. Consuming data advances the pointer instead of
+     moving the remaining bytes. */
   char * read_buffer;
   size_t read_buffer_len;
+  char * read_buffer_base;
+  size_t read_buffer_size;
 
   mailstream_low * low;
   
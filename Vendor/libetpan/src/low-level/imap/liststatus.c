@@ -0,0 +1,305 @@
+/*
+ * libEtPan! -- a mail stuff library
+ *
+ * Copyright (C) 2001, 2005 - DINH Viet Hoa
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the libEtPan! project nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#	include <config.h>
+#endif
+
+#include "liststatus.h"
+
+#include <stdlib.h>
+
+#include "mailimap.h"
+#include "mailimap_sender.h"
+
+#define STATUS_PIPELINE_DEPTH 64
+
+static int mailimap_list_status_send(mailstream * fd,
+    const char * mb, const char * list_mb,
+    struct mailimap_status_att_list * status_att_list)
+{
+  int r;
+
+  r = mailimap_list_send(fd, mb, list_mb);
+  if (r != MAILIMAP_NO_ERROR)
+    return r;
+
+  r = mailimap_space_send(fd);
+  if (r != MAILIMAP_NO_ERROR)
+    return r;
+
+  r = mailimap_token_send(fd, "RETURN");
+  if (r != MAILIMAP_NO_ERROR)
+    return r;
+
+  r = mailimap_space_send(fd);
+  if (r != MAILIMAP_NO_ERROR)
+    return r;
+
+  r = mailimap_char_send(fd, '(');
+  if (r != MAILIMAP_NO_ERROR)
+    return r;
+
+  r = mailimap_token_send(fd, "STATUS");
+  if (r != MAILIMAP_NO_ERROR)
+    return r;
+
+  r = mailimap_space_send(fd);
+  if (r != MAILIMAP_NO_ERROR)
+    return r;
+
+  r = mailimap_char_send(fd, '(');
+  if (r != MAILIMAP_NO_ERROR)
+    return r;
+
+  r = mailimap_status_att_list_send(fd, status_att_list);
+  if (r != MAILIMAP_NO_ERROR)
+    return r;
+
+  r = mailimap_char_send(fd, ')');
+  if (r != MAILIMAP_NO_ERROR)
+    return r;
+
+  r = mailimap_char_send(fd, ')');
+  if (r != MAILIMAP_NO_ERROR)
+    return r;
+
+  return MAILIMAP_NO_ERROR;
+}
+
+/* moves the STATUS responses of the last command to status_list */
+
+static int take_status_responses(mailimap * session, clist * status_list)
+{
+  struct mailimap_response_info * resp_info;
+  int r;
+
+  resp_info = session->imap_response_info;
+  if (resp_info == NULL)
+    return MAILIMAP_NO_ERROR;
+
+  if (resp_info->rsp_status_list != NULL) {
+    clist_concat(status_list, resp_info->rsp_status_list);
+  }
+
+  if (resp_info->rsp_status != NULL) {
+    r = clist_append(status_list, resp_info->rsp_status);
+    if (r < 0)
+      return MAILIMAP_ERROR_MEMORY;
+    resp_info->rsp_status = NULL;
+  }
+
+  return MAILIMAP_NO_ERROR;
+}
+
+LIBETPAN_EXPORT
+int mailimap_list_status(mailimap * session, const char * mb,
+    const char * list_mb,
+    struct mailimap_status_att_list * status_att_list,
+    clist ** result)
+{
+  struct mailimap_response * response;
+  int r;
+  int res;
+  int error_code;
+  clist * status_list;
+
+  if ((session->imap_state != MAILIMAP_STATE_AUTHENTICATED) &&
+      (session->imap_state != MAILIMAP_STATE_SELECTED))
+    return MAILIMAP_ERROR_BAD_STATE;
+
+  r = mailimap_send_current_tag(session);
+  if (r != MAILIMAP_NO_ERROR)
+    return r;
+
+  r = mailimap_list_status_send(session->imap_stream, mb, list_mb,
+      status_att_list);
+  if (r != MAILIMAP_NO_ERROR)
+    return r;
+
+  r = mailimap_crlf_send(session->imap_stream);
+  if (r != MAILIMAP_NO_ERROR)
+    return r;
+
+  if (mailstream_flush(session->imap_stream) == -1)
+    return MAILIMAP_ERROR_STREAM;
+
+  if (mailimap_read_line(session) == NULL)
+    return MAILIMAP_ERROR_STREAM;
+
+  r = mailimap_parse_response(session, &response);
+  if (r != MAILIMAP_NO_ERROR)
+    return r;
+
+  status_list = clist_new();
+  if (status_list == NULL) {
+    res = MAILIMAP_ERROR_MEMORY;
+    goto free_response;
+  }
+
+  r = take_status_responses(session, status_list);
+  if (r != MAILIMAP_NO_ERROR) {
+    res = r;
+    goto free_list;
+  }
+
+  error_code = response->rsp_resp_done->rsp_data.rsp_tagged->rsp_cond_state->rsp_type;
+
+  mailimap_response_free(response);
+
+  if (error_code != MAILIMAP_RESP_COND_STATE_OK) {
+    mailimap_list_status_free(status_list);
+    return MAILIMAP_ERROR_LIST;
+  }
+
+  * result = status_list;
+
+  return MAILIMAP_NO_ERROR;
+
+ free_list:
+  mailimap_list_status_free(status_list);
+ free_response:
+  mailimap_response_free(response);
+  return res;
+}
+
+LIBETPAN_EXPORT
+int mailimap_status_pipelined(mailimap * session, clist * mb_list,
+    struct mailimap_status_att_list * status_att_list,
+    clist ** result)
+{
+  struct mailimap_response * response;
+  clistiter * cur;
+  clist * status_list;
+  int first_tag;
+  int last_tag;
+  int r;
+  int res;
+
+  if ((session->imap_state != MAILIMAP_STATE_AUTHENTICATED) &&
+      (session->imap_state != MAILIMAP_STATE_SELECTED))
+    return MAILIMAP_ERROR_BAD_STATE;
+
+  status_list = clist_new();
+  if (status_list == NULL)
+    return MAILIMAP_ERROR_MEMORY;
+
+  cur = clist_begin(mb_list);
+  while (cur != NULL) {
+    unsigned int count;
+    unsigned int i;
+
+    /* send a batch of commands */
+    first_tag = session->imap_tag + 1;
+    count = 0;
+    while ((cur != NULL) && (count < STATUS_PIPELINE_DEPTH)) {
+      r = mailimap_send_current_tag(session);
+      if (r != MAILIMAP_NO_ERROR) {
+        res = r;
+        goto free_list;
+      }
+
+      r = mailimap_status_send(session->imap_stream, clist_content(cur),
+          status_att_list);
+      if (r != MAILIMAP_NO_ERROR) {
+        res = r;
+        goto free_list;
+      }
+
+      r = mailimap_crlf_send(session->imap_stream);
+      if (r != MAILIMAP_NO_ERROR) {
+        res = r;
+        goto free_list;
+      }
+
+      count ++;
+      cur = clist_next(cur);
+    }
+    last_tag = session->imap_tag;
+
+    if (mailstream_flush(session->imap_stream) == -1) {
+      res = MAILIMAP_ERROR_STREAM;
+      goto free_list;
+    }
+
+    /* read the responses in order, each one is matched against its own tag */
+    for(i = 0 ; i < count ; i ++) {
+      session->imap_tag = first_tag + i;
+
+      if (mailimap_read_line(session) == NULL) {
+        res = MAILIMAP_ERROR_STREAM;
+        goto restore_tag;
+      }
+
+      r = mailimap_parse_response(session, &response);
+      if (r != MAILIMAP_NO_ERROR) {
+        res = r;
+        goto restore_tag;
+      }
+
+      if (response->rsp_resp_done->rsp_data.rsp_tagged->rsp_cond_state->rsp_type ==
+          MAILIMAP_RESP_COND_STATE_OK) {
+        r = take_status_responses(session, status_list);
+        if (r != MAILIMAP_NO_ERROR) {
+          mailimap_response_free(response);
+          res = r;
+          goto restore_tag;
+        }
+      }
+
+      mailimap_response_free(response);
+    }
+  }
+
+  * result = status_list;
+
+  return MAILIMAP_NO_ERROR;
+
+ restore_tag:
+  session->imap_tag = last_tag;
+ free_list:
+  mailimap_list_status_free(status_list);
+  return res;
+}
+
+LIBETPAN_EXPORT
+void mailimap_list_status_free(clist * status_list)
+{
+  clist_foreach(status_list,
+      (clist_func) mailimap_mailbox_data_status_free, NULL);
+  clist_free(status_list);
+}
+
+LIBETPAN_EXPORT
+int mailimap_has_list_status(mailimap * session)
+{
+  return mailimap_has_extension(session, "LIST-STATUS");
+}
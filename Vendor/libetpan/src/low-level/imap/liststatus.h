@@ -0,0 +1,102 @@
+/*
+ * libEtPan! -- a mail stuff library
+ *
+ * Copyright (C) 2001, 2005 - DINH Viet Hoa
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the libEtPan! project nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef LISTSTATUS_H
+
+#define LISTSTATUS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <libetpan/libetpan-config.h>
+#include <libetpan/mailimap_types.h>
+
+/*
+  mailimap_list_status()
+
+  sends LIST mb list_mb RETURN (STATUS (status_att_list)) (RFC 5819) and
+  collects the STATUS responses the server interleaves with the LIST
+  responses. Mailboxes that can't be selected have no STATUS response.
+
+  @param session          IMAP session
+  @param mb               reference name
+  @param list_mb          mailbox name with possible wildcards
+  @param status_att_list  status attributes to return for each mailbox
+  @param result           a list of (struct mailimap_mailbox_data_status *)
+                          will be stored here. It must be freed with
+                          mailimap_list_status_free().
+
+  @return the return code is one of MAILIMAP_ERROR_XXX or
+    MAILIMAP_NO_ERROR codes
+*/
+
+LIBETPAN_EXPORT
+int mailimap_list_status(mailimap * session, const char * mb,
+    const char * list_mb,
+    struct mailimap_status_att_list * status_att_list,
+    clist ** result);
+
+/*
+  mailimap_status_pipelined()
+
+  sends a STATUS command for every mailbox of mb_list without waiting for
+  the previous one to complete, then reads the responses. Commands are
+  sent in batches so that neither side blocks on a full socket buffer.
+  Mailboxes for which the server answers NO are skipped.
+
+  @param session          IMAP session
+  @param mb_list          a list of (char *) mailbox names
+  @param status_att_list  status attributes to return for each mailbox
+  @param result           a list of (struct mailimap_mailbox_data_status *)
+                          will be stored here. It must be freed with
+                          mailimap_list_status_free().
+
+  @return the return code is one of MAILIMAP_ERROR_XXX or
+    MAILIMAP_NO_ERROR codes
+*/
+
+LIBETPAN_EXPORT
+int mailimap_status_pipelined(mailimap * session, clist * mb_list,
+    struct mailimap_status_att_list * status_att_list,
+    clist ** result);
+
+LIBETPAN_EXPORT
+void mailimap_list_status_free(clist * status_list);
+
+LIBETPAN_EXPORT
+int mailimap_has_list_status(mailimap * session);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -42,6 +42,7 @@
 #include "mailimap_sender.h"
 #include "mailimap_extension.h"
 #include "mail.h"
+#include "carena.h"
 #include "condstore.h"
 #include "condstore_private.h"
 
@@ -311,8 +312,15 @@ static void mailbox_data_store(mailimap * session,
 
   case MAILIMAP_MAILBOX_DATA_STATUS:
     if (session->imap_response_info) {
-      if (session->imap_response_info->rsp_status != NULL)
-        mailimap_mailbox_data_status_free(session->imap_response_info->rsp_status);
+      if (session->imap_response_info->rsp_status != NULL) {
+        /* keep earlier STATUS responses, LIST-STATUS returns one per mailbox */
+        if (session->imap_response_info->rsp_status_list == NULL)
+          session->imap_response_info->rsp_status_list = clist_new();
+        if ((session->imap_response_info->rsp_status_list == NULL) ||
+            (clist_append(session->imap_response_info->rsp_status_list,
+                session->imap_response_info->rsp_status) < 0))
+          mailimap_mailbox_data_status_free(session->imap_response_info->rsp_status);
+      }
       session->imap_response_info->rsp_status = mb_data->mbd_data.mbd_status;
 #if 0
       if (session->imap_selection_info != NULL) {
@@ -2675,6 +2683,7 @@ mailimap * mailimap_new(size_t imap_progr_rate,
   f->is_163_workaround_enabled = 0;
   f->is_rambler_workaround_enabled = 0;
   f->is_qip_workaround_enabled = 0;
+  f->imap_arena = NULL;
   return f;
   
  free_stream_buffer:
@@ -2707,6 +2716,8 @@ void mailimap_free(mailimap * session)
     mailimap_selection_info_free(session->imap_selection_info);
   if (session->imap_connection_info)
     mailimap_connection_info_free(session->imap_connection_info);
+  if (session->imap_arena)
+    carena_free(session->imap_arena);
 
   free(session);
 }
@@ -2804,3 +2815,33 @@ LIBETPAN_EXPORT
 int mailimap_is_qip_workaround_enabled(mailimap * session) {
   return session->is_qip_workaround_enabled;
 }
+
+#define ARENA_CHUNK_SIZE (16 * 1024)
+
+LIBETPAN_EXPORT
+void mailimap_set_arena_enabled(mailimap * session, int enabled) {
+  if (enabled) {
+    if (session->imap_arena == NULL)
+      session->imap_arena = carena_new(ARENA_CHUNK_SIZE);
+  }
+  else {
+    if (session->imap_arena != NULL) {
+      carena_free(session->imap_arena);
+      session->imap_arena = NULL;
+    }
+  }
+}
+
+LIBETPAN_EXPORT
+int mailimap_is_arena_enabled(mailimap * session) {
+  return session->imap_arena != NULL;
+}
+
+LIBETPAN_EXPORT
+void mailimap_get_arena_stats(mailimap * session, struct carena_stats * stats) {
+  if (session->imap_arena == NULL) {
+    memset(stats, 0, sizeof(* stats));
+    return;
+  }
+  carena_get_stats(session->imap_arena, stats);
+}
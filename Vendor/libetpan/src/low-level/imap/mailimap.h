@@ -57,6 +57,7 @@ extern "C" {
 #include <libetpan/mailimap_id.h>
 #include <libetpan/enable.h>
 #include <libetpan/xlist.h>
+#include <libetpan/liststatus.h>
 #include <libetpan/xgmlabels.h>
 #include <libetpan/xgmmsgid.h>
 #include <libetpan/xgmthrid.h>
@@ -65,6 +66,7 @@ extern "C" {
 #include <libetpan/mailimap_sort.h>
 #include <libetpan/mailimap_compress.h>
 #include <libetpan/mailimap_oauth2.h>
+#include <libetpan/carena.h>
 
 /*
   mailimap_connect()
@@ -928,6 +930,35 @@ int mailimap_is_qip_workaround_enabled(mailimap * session);
 LIBETPAN_EXPORT
 void mailimap_set_qip_workaround_enabled(mailimap * session, int enabled);
 
+#ifndef LIBETPAN_HAS_MAILIMAP_ARENA
+#define LIBETPAN_HAS_MAILIMAP_ARENA	1
+#endif
+
+/*
+    mailimap_set_arena_enabled() makes FETCH responses handled by a
+      msg_att handler (see mailimap_set_msg_att_handler()) be built in an
+      arena. Each message is released in one step once the handler returns,
+      instead of freeing its attributes, lists and addresses one by one.
+      The msg_att passed to the handler must not be kept after it returns.
+
+    @param session    IMAP session
+    @param enabled    1 to enable, 0 to disable and release the arena.
+*/
+
+LIBETPAN_EXPORT
+void mailimap_set_arena_enabled(mailimap * session, int enabled);
+
+LIBETPAN_EXPORT
+int mailimap_is_arena_enabled(mailimap * session);
+
+/*
+    mailimap_get_arena_stats() returns the allocation counters of the arena.
+      They are all zero when the arena is disabled.
+*/
+
+LIBETPAN_EXPORT
+void mailimap_get_arena_stats(mailimap * session, struct carena_stats * stats);
+
 #ifdef __cplusplus
 }
 #endif
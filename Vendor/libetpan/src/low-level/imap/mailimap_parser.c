@@ -45,6 +45,7 @@
 #include "mailimap_keywords.h"
 #include "mailimap_parser.h"
 #include "mailimap_extension.h"
+#include "carena.h"
 #include "mmapstring.h"
 #include "mail.h"
 #include "timeutils.h"
@@ -6076,6 +6077,26 @@ static int is_list_wildcards(char ch)
 }
 
 
+/* The body handler is caller code: whatever it allocates must not come from
+   the arena, which is reset once the message has been handled. */
+static bool msg_body_handler_call(struct mailimap_parser_context * parser_ctx,
+                                  const char * bytes, size_t len)
+{
+  int allocating;
+  bool result;
+  
+  allocating = 0;
+  if (parser_ctx->arena != NULL)
+    allocating = carena_set_allocating(parser_ctx->arena, 0);
+  result = parser_ctx->msg_body_handler(parser_ctx->msg_body_att_type, parser_ctx->msg_body_section,
+                                        bytes, len,
+                                        parser_ctx->msg_body_handler_context);
+  if (parser_ctx->arena != NULL)
+    carena_set_allocating(parser_ctx->arena, allocating);
+  
+  return result;
+}
+
 /*
    literal         = "{" number "}" CRLF *CHAR8
                        ; Number represents the number of CHAR8s
@@ -6168,9 +6189,7 @@ static int mailimap_literal_parse_progress(mailstream * fd, MMAPString * buffer,
   if (left >= number) {
     if (number > 0) {
       if (use_msg_body_handler) {
-        if (!parser_ctx->msg_body_handler(parser_ctx->msg_body_att_type, parser_ctx->msg_body_section,
-                                          buffer->str + cur_token, number,
-                                          parser_ctx->msg_body_handler_context)) {
+        if (!msg_body_handler_call(parser_ctx, buffer->str + cur_token, number)) {
           res = MAILIMAP_ERROR_MEMORY;
           goto free_literal;
         }
@@ -6201,9 +6220,7 @@ static int mailimap_literal_parse_progress(mailstream * fd, MMAPString * buffer,
     needed = number - left;
     if (left > 0) {
       if (use_msg_body_handler) {
-        if (!parser_ctx->msg_body_handler(parser_ctx->msg_body_att_type, parser_ctx->msg_body_section,
-                                          buffer->str + cur_token, left,
-                                          parser_ctx->msg_body_handler_context)) {
+        if (!msg_body_handler_call(parser_ctx, buffer->str + cur_token, left)) {
           res = MAILIMAP_ERROR_MEMORY;
           goto free_literal;
         }
@@ -6235,9 +6252,7 @@ static int mailimap_literal_parse_progress(mailstream * fd, MMAPString * buffer,
       if (use_msg_body_handler) {
         read_bytes = mailstream_read(fd, read_buffer, bytes_to_read);
         if (read_bytes > 0) {
-          if (!parser_ctx->msg_body_handler(parser_ctx->msg_body_att_type, parser_ctx->msg_body_section,
-                                            read_buffer, read_bytes,
-                                            parser_ctx->msg_body_handler_context)) {
+          if (!msg_body_handler_call(parser_ctx, read_buffer, read_bytes)) {
             res = MAILIMAP_ERROR_MEMORY;
             goto free_literal;
           }
@@ -7626,6 +7641,7 @@ mailimap_message_data_parse_progress(mailstream * fd, MMAPString * buffer, struc
   int type;
   struct mailimap_msg_att * msg_att;
   struct mailimap_message_data * msg_data;
+  int use_arena;
   int r;
   int res;
 
@@ -7681,8 +7697,15 @@ mailimap_message_data_parse_progress(mailstream * fd, MMAPString * buffer, struc
       goto err;
     }
 
+    /* only a msg_att that is handed to msg_att_handler and freed right after
+       can live in the arena, see mailimap_response_data_parse_progress() */
+    use_arena = (parser_ctx->arena != NULL) && (msg_att_handler != NULL);
+    if (use_arena)
+      carena_set_allocating(parser_ctx->arena, 1);
     r = mailimap_msg_att_parse_progress(fd, buffer, parser_ctx, &cur_token, &msg_att,
 			       progr_rate, progr_fun, body_progr_fun, items_progr_fun, context, msg_att_handler, msg_att_context);
+    if (use_arena)
+      carena_set_allocating(parser_ctx->arena, 0);
     if (r != MAILIMAP_NO_ERROR) {
       res = r;
       goto err;
@@ -9338,6 +9361,8 @@ mailimap_response_data_parse_progress(mailstream * fd, MMAPString * buffer, stru
   struct mailimap_message_data * msg_data;
   struct mailimap_capability_data * cap_data;
   struct mailimap_extension_data * ext_data;
+  carena * previous_arena;
+  int use_arena;
   int r;
   int res;
   int msg_att_handled;
@@ -9351,6 +9376,13 @@ mailimap_response_data_parse_progress(mailstream * fd, MMAPString * buffer, stru
 
   cur_token = * indx;
 
+  /* The arena stays current for the whole response line so that the frees
+     below recognize the msg_att it holds. */
+  previous_arena = NULL;
+  use_arena = (parser_ctx->arena != NULL) && (msg_att_handler != NULL);
+  if (use_arena)
+    previous_arena = carena_set_current(parser_ctx->arena);
+
   r = mailimap_star_parse(fd, buffer, parser_ctx, &cur_token);
   if (r != MAILIMAP_NO_ERROR) {
     res = r;
@@ -9428,6 +9460,8 @@ mailimap_response_data_parse_progress(mailstream * fd, MMAPString * buffer, stru
         mailimap_message_data_free(msg_data);
         msg_data = NULL;
         msg_att_handled = 1;
+        if (use_arena)
+          carena_reset(parser_ctx->arena);
       }
     }
   }
@@ -9448,6 +9482,9 @@ mailimap_response_data_parse_progress(mailstream * fd, MMAPString * buffer, stru
   * result = resp_data;
   * indx = cur_token;
 
+  if (use_arena)
+    carena_set_current(previous_arena);
+
   return MAILIMAP_NO_ERROR;
 
  free:
@@ -9464,6 +9501,10 @@ mailimap_response_data_parse_progress(mailstream * fd, MMAPString * buffer, stru
   if (ext_data)
     mailimap_extension_data_free(ext_data);
  err:
+  if (use_arena) {
+    carena_reset(parser_ctx->arena);
+    carena_set_current(previous_arena);
+  }
   return res;
 }
 
@@ -42,6 +42,7 @@
 #include "mail.h"
 #include "mailimap_extension.h"
 #include "mailimap.h"
+#include "carena.h"
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -67,7 +68,7 @@ uint32_t * mailimap_number_alloc_new(uint32_t number)
 {
   uint32_t * pnumber;
 
-  pnumber = malloc(sizeof(* pnumber));
+  pnumber = carena_malloc(sizeof(* pnumber));
   if (pnumber == NULL)
     return NULL;
 
@@ -79,7 +80,7 @@ uint32_t * mailimap_number_alloc_new(uint32_t number)
 LIBETPAN_EXPORT
 void mailimap_number_alloc_free(uint32_t * pnumber)
 {
-  free(pnumber);
+  carena_release(pnumber);
 }
 
 
@@ -93,7 +94,7 @@ mailimap_address_new(char * ad_personal_name, char * ad_source_route,
 {
   struct mailimap_address * addr;
 
-  addr = malloc(sizeof(* addr));
+  addr = carena_malloc(sizeof(* addr));
   if (addr == NULL)
     return NULL;
 
@@ -112,7 +113,7 @@ void mailimap_address_free(struct mailimap_address * addr)
   mailimap_addr_mailbox_free(addr->ad_mailbox_name);
   mailimap_addr_adl_free(addr->ad_source_route);
   mailimap_addr_name_free(addr->ad_personal_name);
-  free(addr);
+  carena_release(addr);
 }
 
 LIBETPAN_EXPORT
@@ -147,19 +148,19 @@ LIBETPAN_EXPORT
 void mailimap_astring_free(char * astring)
 {
   if (mmap_string_unref(astring) != 0)
-    free(astring);
+    carena_release(astring);
 }
 
 static void mailimap_custom_string_free(char * str)
 {
-  free(str);
+  carena_release(str);
 }
 
 
 LIBETPAN_EXPORT
 void mailimap_atom_free(char * atom)
 {
-  free(atom);
+  carena_release(atom);
 }
 
 
@@ -178,7 +179,7 @@ void mailimap_auth_type_free(char * auth_type)
 LIBETPAN_EXPORT
 void mailimap_base64_free(char * base64)
 {
-  free(base64);
+  carena_release(base64);
 }
 
 
@@ -192,7 +193,7 @@ mailimap_body_new(int bd_type,
 {
   struct mailimap_body * body;
   
-  body = malloc(sizeof(* body));
+  body = carena_malloc(sizeof(* body));
   if (body == NULL)
     return NULL;
 
@@ -220,7 +221,7 @@ void mailimap_body_free(struct mailimap_body * body)
     mailimap_body_type_mpart_free(body->bd_data.bd_body_mpart);
     break;
   }
-  free(body);
+  carena_release(body);
 }
 
 
@@ -232,7 +233,7 @@ mailimap_body_extension_new(int ext_type, char * ext_nstring,
 {
   struct mailimap_body_extension * body_extension;
 
-  body_extension = malloc(sizeof(* body_extension));
+  body_extension = carena_malloc(sizeof(* body_extension));
   if (body_extension == NULL)
     return NULL;
 
@@ -267,7 +268,7 @@ void mailimap_body_extension_free(struct mailimap_body_extension * be)
     break;
   }
   
-  free(be);
+  carena_release(be);
 }
 
 
@@ -290,7 +291,7 @@ mailimap_body_ext_1part_new(char * bd_md5,
 {
   struct mailimap_body_ext_1part * body_ext_1part;
   
-  body_ext_1part = malloc(sizeof(* body_ext_1part));
+  body_ext_1part = carena_malloc(sizeof(* body_ext_1part));
   if (body_ext_1part == NULL)
     return NULL;
 
@@ -316,7 +317,7 @@ mailimap_body_ext_1part_free(struct mailimap_body_ext_1part * body_ext_1part)
     mailimap_body_ext_list_free(body_ext_1part->bd_extension_list);
   mailimap_body_fld_loc_free(body_ext_1part->bd_loc);
 
-  free(body_ext_1part);
+  carena_release(body_ext_1part);
 }
 
 LIBETPAN_EXPORT
@@ -329,7 +330,7 @@ mailimap_body_ext_mpart_new(struct mailimap_body_fld_param * bd_parameter,
 {
   struct mailimap_body_ext_mpart * body_ext_mpart;
 
-  body_ext_mpart = malloc(sizeof(* body_ext_mpart));
+  body_ext_mpart = carena_malloc(sizeof(* body_ext_mpart));
   if (body_ext_mpart == NULL)
     return NULL;
 
@@ -355,7 +356,7 @@ mailimap_body_ext_mpart_free(struct mailimap_body_ext_mpart * body_ext_mpart)
   if (body_ext_mpart->bd_extension_list)
     mailimap_body_ext_list_free(body_ext_mpart->bd_extension_list);
   mailimap_body_fld_loc_free(body_ext_mpart->bd_loc);
-  free(body_ext_mpart);
+  carena_release(body_ext_mpart);
 }
 
 
@@ -369,7 +370,7 @@ mailimap_body_fields_new(struct mailimap_body_fld_param * bd_parameter,
 {
   struct mailimap_body_fields * body_fields;
 
-  body_fields = malloc(sizeof(* body_fields));
+  body_fields = carena_malloc(sizeof(* body_fields));
   if (body_fields == NULL)
     return NULL;
   body_fields->bd_parameter = bd_parameter;
@@ -390,7 +391,7 @@ mailimap_body_fields_free(struct mailimap_body_fields * body_fields)
   mailimap_body_fld_id_free(body_fields->bd_id);
   mailimap_body_fld_desc_free(body_fields->bd_description);
   mailimap_body_fld_enc_free(body_fields->bd_encoding);
-  free(body_fields);
+  carena_release(body_fields);
 }
 
 
@@ -414,7 +415,7 @@ mailimap_body_fld_dsp_new(char * dsp_type,
 {
   struct mailimap_body_fld_dsp * body_fld_dsp;
 
-  body_fld_dsp = malloc(sizeof(* body_fld_dsp));
+  body_fld_dsp = carena_malloc(sizeof(* body_fld_dsp));
   if (body_fld_dsp == NULL)
     return NULL;
 
@@ -431,7 +432,7 @@ void mailimap_body_fld_dsp_free(struct mailimap_body_fld_dsp * bfd)
     mailimap_string_free(bfd->dsp_type);
   if (bfd->dsp_attributes != NULL)
     mailimap_body_fld_param_free(bfd->dsp_attributes);
-  free(bfd);
+  carena_release(bfd);
 }
 
 
@@ -442,7 +443,7 @@ mailimap_body_fld_enc_new(int enc_type, char * enc_value)
 {
   struct mailimap_body_fld_enc * body_fld_enc;
 
-  body_fld_enc = malloc(sizeof(* body_fld_enc));
+  body_fld_enc = carena_malloc(sizeof(* body_fld_enc));
   if (body_fld_enc == NULL)
     return NULL;
   
@@ -457,7 +458,7 @@ void mailimap_body_fld_enc_free(struct mailimap_body_fld_enc * bfe)
 {
   if (bfe->enc_value)
     mailimap_string_free(bfe->enc_value);
-  free(bfe);
+  carena_release(bfe);
 }
 
 
@@ -476,7 +477,7 @@ mailimap_body_fld_lang_new(int lg_type, char * lg_single, clist * lg_list)
 {
   struct mailimap_body_fld_lang * fld_lang;
 
-  fld_lang = malloc(sizeof(* fld_lang));
+  fld_lang = carena_malloc(sizeof(* fld_lang));
   if (fld_lang == NULL)
     return NULL;
   
@@ -507,7 +508,7 @@ mailimap_body_fld_lang_free(struct mailimap_body_fld_lang * fld_lang)
     clist_free(fld_lang->lg_data.lg_list);
     break;
   }
-  free(fld_lang);
+  carena_release(fld_lang);
 }
 
 
@@ -531,7 +532,7 @@ mailimap_single_body_fld_param_new(char * pa_name, char * pa_value)
 {
   struct mailimap_single_body_fld_param * param;
 
-  param = malloc(sizeof(* param));
+  param = carena_malloc(sizeof(* param));
   if (param == NULL)
     return NULL;
   param->pa_name = pa_name;
@@ -546,7 +547,7 @@ mailimap_single_body_fld_param_free(struct mailimap_single_body_fld_param * p)
 {
   mailimap_string_free(p->pa_name);
   mailimap_string_free(p->pa_value);
-  free(p);
+  carena_release(p);
 }
 
 
@@ -556,7 +557,7 @@ mailimap_body_fld_param_new(clist * pa_list)
 {
   struct mailimap_body_fld_param * fld_param;
 
-  fld_param = malloc(sizeof(* fld_param));
+  fld_param = carena_malloc(sizeof(* fld_param));
   if (fld_param == NULL)
     return NULL;
   fld_param->pa_list = pa_list;
@@ -571,7 +572,7 @@ mailimap_body_fld_param_free(struct mailimap_body_fld_param * fld_param)
   clist_foreach(fld_param->pa_list,
 		(clist_func) mailimap_single_body_fld_param_free, NULL);
   clist_free(fld_param->pa_list);
-  free(fld_param);
+  carena_release(fld_param);
 }
 
 
@@ -585,7 +586,7 @@ mailimap_body_type_1part_new(int bd_type,
 {
   struct mailimap_body_type_1part * body_type_1part;
 
-  body_type_1part = malloc(sizeof(* body_type_1part));
+  body_type_1part = carena_malloc(sizeof(* body_type_1part));
   if (body_type_1part == NULL)
     return NULL;
   
@@ -624,7 +625,7 @@ mailimap_body_type_1part_free(struct mailimap_body_type_1part * bt1p)
   if (bt1p->bd_ext_1part)
     mailimap_body_ext_1part_free(bt1p->bd_ext_1part);
 
-  free(bt1p);
+  carena_release(bt1p);
 }
 
 
@@ -636,7 +637,7 @@ mailimap_body_type_basic_new(struct mailimap_media_basic * bd_media_basic,
 {
   struct mailimap_body_type_basic * body_type_basic;
 
-  body_type_basic = malloc(sizeof(* body_type_basic));
+  body_type_basic = carena_malloc(sizeof(* body_type_basic));
   if (body_type_basic == NULL)
     return NULL;
 
@@ -652,7 +653,7 @@ void mailimap_body_type_basic_free(struct mailimap_body_type_basic *
 {
   mailimap_media_basic_free(body_type_basic->bd_media_basic);
   mailimap_body_fields_free(body_type_basic->bd_fields);
-  free(body_type_basic);
+  carena_release(body_type_basic);
 }
 
 
@@ -663,7 +664,7 @@ mailimap_body_type_mpart_new(clist * bd_list, char * bd_media_subtype,
 {
   struct mailimap_body_type_mpart * body_type_mpart;
 
-  body_type_mpart = malloc(sizeof(* body_type_mpart));
+  body_type_mpart = carena_malloc(sizeof(* body_type_mpart));
   if (body_type_mpart == NULL)
     return NULL;
 
@@ -685,7 +686,7 @@ void mailimap_body_type_mpart_free(struct mailimap_body_type_mpart *
   if (body_type_mpart->bd_ext_mpart)
     mailimap_body_ext_mpart_free(body_type_mpart->bd_ext_mpart);
 
-  free(body_type_mpart);
+  carena_release(body_type_mpart);
 }
 
 
@@ -698,7 +699,7 @@ mailimap_body_type_msg_new(struct mailimap_body_fields * bd_fields,
 {
   struct mailimap_body_type_msg * body_type_msg;
 
-  body_type_msg = malloc(sizeof(* body_type_msg));
+  body_type_msg = carena_malloc(sizeof(* body_type_msg));
   if (body_type_msg == NULL)
     return NULL;
 
@@ -717,7 +718,7 @@ mailimap_body_type_msg_free(struct mailimap_body_type_msg * body_type_msg)
   mailimap_body_fields_free(body_type_msg->bd_fields);
   mailimap_envelope_free(body_type_msg->bd_envelope);
   mailimap_body_free(body_type_msg->bd_body);
-  free(body_type_msg);
+  carena_release(body_type_msg);
 }
 
 
@@ -730,7 +731,7 @@ mailimap_body_type_text_new(char * bd_media_text,
 {
   struct mailimap_body_type_text * body_type_text;
 
-  body_type_text = malloc(sizeof(* body_type_text));
+  body_type_text = carena_malloc(sizeof(* body_type_text));
   if (body_type_text == NULL)
     return NULL;
 
@@ -747,7 +748,7 @@ mailimap_body_type_text_free(struct mailimap_body_type_text * body_type_text)
 {
   mailimap_media_text_free(body_type_text->bd_media_text);
   mailimap_body_fields_free(body_type_text->bd_fields);
-  free(body_type_text);
+  carena_release(body_type_text);
 }
 
 
@@ -758,7 +759,7 @@ mailimap_capability_new(int cap_type, char * cap_auth_type, char * cap_name)
 {
   struct mailimap_capability * cap;
 
-  cap = malloc(sizeof(* cap));
+  cap = carena_malloc(sizeof(* cap));
   if (cap == NULL)
     return NULL;
   cap->cap_type = cap_type;
@@ -779,13 +780,13 @@ void mailimap_capability_free(struct mailimap_capability * c)
 {
   switch (c->cap_type) {
   case MAILIMAP_CAPABILITY_AUTH_TYPE:
-    free(c->cap_data.cap_auth_type);
+    carena_release(c->cap_data.cap_auth_type);
     break;
   case MAILIMAP_CAPABILITY_NAME:
-    free(c->cap_data.cap_name);
+    carena_release(c->cap_data.cap_name);
     break;
   }
-  free(c);
+  carena_release(c);
 }
 
 
@@ -795,7 +796,7 @@ mailimap_capability_data_new(clist * cap_list)
 {
   struct mailimap_capability_data * cap_data;
 
-  cap_data = malloc(sizeof(* cap_data));
+  cap_data = carena_malloc(sizeof(* cap_data));
   if (cap_data == NULL)
     return NULL;
 
@@ -813,7 +814,7 @@ mailimap_capability_data_free(struct mailimap_capability_data * cap_data)
         (clist_func) mailimap_capability_free, NULL);
     clist_free(cap_data->cap_list);
   }
-  free(cap_data);
+  carena_release(cap_data);
 }
 
 
@@ -826,7 +827,7 @@ mailimap_continue_req_new(int cr_type, struct mailimap_resp_text * cr_text,
 {
   struct mailimap_continue_req * cont_req;
 
-  cont_req = malloc(sizeof(* cont_req));
+  cont_req = carena_malloc(sizeof(* cont_req));
   if (cont_req == NULL)
     return NULL;
   cont_req->cr_type = cr_type;
@@ -853,7 +854,7 @@ void mailimap_continue_req_free(struct mailimap_continue_req * cont_req)
     mailimap_base64_free(cont_req->cr_data.cr_base64);
     break;
   }
-  free(cont_req);
+  carena_release(cont_req);
 }
 
 LIBETPAN_EXPORT
@@ -863,7 +864,7 @@ mailimap_date_time_new(int dt_day, int dt_month, int dt_year, int dt_hour,
 {
   struct mailimap_date_time * date_time;
 
-  date_time = malloc(sizeof(* date_time));
+  date_time = carena_malloc(sizeof(* date_time));
   if (date_time == NULL)
     return NULL;
 
@@ -881,7 +882,7 @@ mailimap_date_time_new(int dt_day, int dt_month, int dt_year, int dt_hour,
 LIBETPAN_EXPORT
 void mailimap_date_time_free(struct mailimap_date_time * date_time)
 {
-  free(date_time);
+  carena_release(date_time);
 }
 
 
@@ -899,7 +900,7 @@ mailimap_envelope_new(char * env_date, char * env_subject,
 {
   struct mailimap_envelope * env;
 
-  env = malloc(sizeof(* env));
+  env = carena_malloc(sizeof(* env));
   if (env == NULL)
     return NULL;
 
@@ -942,7 +943,7 @@ void mailimap_envelope_free(struct mailimap_envelope * env)
   if (env->env_message_id)
     mailimap_env_message_id_free(env->env_message_id);
 
-  free(env);
+  carena_release(env);
 }
 
 
@@ -960,7 +961,7 @@ struct mailimap_env_bcc * mailimap_env_bcc_new(clist * bcc_list)
 {
   struct mailimap_env_bcc * env_bcc;
 
-  env_bcc = malloc(sizeof(* env_bcc));
+  env_bcc = carena_malloc(sizeof(* env_bcc));
   if (env_bcc == NULL)
     return NULL;
   env_bcc->bcc_list = bcc_list;
@@ -972,7 +973,7 @@ LIBETPAN_EXPORT
 void mailimap_env_bcc_free(struct mailimap_env_bcc * env_bcc)
 {
   mailimap_address_list_free(env_bcc->bcc_list);
-  free(env_bcc);
+  carena_release(env_bcc);
 }
 
 
@@ -981,7 +982,7 @@ struct mailimap_env_cc * mailimap_env_cc_new(clist * cc_list)
 {
   struct mailimap_env_cc * env_cc;
 
-  env_cc = malloc(sizeof(* env_cc));
+  env_cc = carena_malloc(sizeof(* env_cc));
   if (env_cc == NULL)
     return NULL;
   env_cc->cc_list = cc_list;
@@ -993,7 +994,7 @@ LIBETPAN_EXPORT
 void mailimap_env_cc_free(struct mailimap_env_cc * env_cc)
 {
   mailimap_address_list_free(env_cc->cc_list);
-  free(env_cc);
+  carena_release(env_cc);
 }
 
 
@@ -1009,7 +1010,7 @@ struct mailimap_env_from * mailimap_env_from_new(clist * frm_list)
 {
   struct mailimap_env_from * env_from;
 
-  env_from = malloc(sizeof(* env_from));
+  env_from = carena_malloc(sizeof(* env_from));
   if (env_from == NULL)
     return NULL;
   env_from->frm_list = frm_list;
@@ -1021,7 +1022,7 @@ LIBETPAN_EXPORT
 void mailimap_env_from_free(struct mailimap_env_from * env_from)
 {
   mailimap_address_list_free(env_from->frm_list);
-  free(env_from);
+  carena_release(env_from);
 }
 
 
@@ -1040,7 +1041,7 @@ struct mailimap_env_reply_to * mailimap_env_reply_to_new(clist * rt_list)
 {
   struct mailimap_env_reply_to * env_reply_to;
 
-  env_reply_to = malloc(sizeof(* env_reply_to));
+  env_reply_to = carena_malloc(sizeof(* env_reply_to));
   if (env_reply_to == NULL)
     return NULL;
   env_reply_to->rt_list = rt_list;
@@ -1053,7 +1054,7 @@ void
 mailimap_env_reply_to_free(struct mailimap_env_reply_to * env_reply_to)
 {
   mailimap_address_list_free(env_reply_to->rt_list);
-  free(env_reply_to);
+  carena_release(env_reply_to);
 }
 
 LIBETPAN_EXPORT
@@ -1061,7 +1062,7 @@ struct mailimap_env_sender * mailimap_env_sender_new(clist * snd_list)
 {
   struct mailimap_env_sender * env_sender;
 
-  env_sender = malloc(sizeof(* env_sender));
+  env_sender = carena_malloc(sizeof(* env_sender));
   if (env_sender == NULL)
     return NULL;
   env_sender->snd_list = snd_list;
@@ -1073,7 +1074,7 @@ LIBETPAN_EXPORT
 void mailimap_env_sender_free(struct mailimap_env_sender * env_sender)
 {
   mailimap_address_list_free(env_sender->snd_list);
-  free(env_sender);
+  carena_release(env_sender);
 }
 
 void mailimap_env_subject_free(char * subject)
@@ -1086,7 +1087,7 @@ struct mailimap_env_to * mailimap_env_to_new(clist * to_list)
 {
   struct mailimap_env_to * env_to;
 
-  env_to = malloc(sizeof(* env_to));
+  env_to = carena_malloc(sizeof(* env_to));
   if (env_to == NULL)
     return NULL;
   env_to->to_list = to_list;
@@ -1098,7 +1099,7 @@ LIBETPAN_EXPORT
 void mailimap_env_to_free(struct mailimap_env_to * env_to)
 {
   mailimap_address_list_free(env_to->to_list);
-  free(env_to);
+  carena_release(env_to);
 }
 
 
@@ -1109,7 +1110,7 @@ struct mailimap_flag * mailimap_flag_new(int fl_type,
 {
   struct mailimap_flag * f;
 
-  f = malloc(sizeof(* f));
+  f = carena_malloc(sizeof(* f));
   if (f == NULL)
     return NULL;
   f->fl_type = fl_type;
@@ -1136,7 +1137,7 @@ void mailimap_flag_free(struct mailimap_flag * f)
     mailimap_flag_extension_free(f->fl_data.fl_extension);
     break;
   }
-  free(f);
+  carena_release(f);
 }
 
 
@@ -1155,7 +1156,7 @@ mailimap_flag_fetch_new(int fl_type, struct mailimap_flag * fl_flag)
 {
   struct mailimap_flag_fetch * flag_fetch;
 
-  flag_fetch = malloc(sizeof(* flag_fetch));
+  flag_fetch = carena_malloc(sizeof(* flag_fetch));
   if (flag_fetch == NULL)
     return NULL;
 
@@ -1170,7 +1171,7 @@ void mailimap_flag_fetch_free(struct mailimap_flag_fetch * flag_fetch)
 {
   if (flag_fetch->fl_flag)
     mailimap_flag_free(flag_fetch->fl_flag);
-  free(flag_fetch);
+  carena_release(flag_fetch);
 }
 
 
@@ -1190,7 +1191,7 @@ mailimap_flag_list_new(clist * fl_list)
 {
   struct mailimap_flag_list * flag_list;
 
-  flag_list = malloc(sizeof(* flag_list));
+  flag_list = carena_malloc(sizeof(* flag_list));
   if (flag_list == NULL)
     return NULL;
   flag_list->fl_list = fl_list;
@@ -1205,7 +1206,7 @@ void mailimap_flag_list_free(struct mailimap_flag_list * flag_list)
     clist_foreach(flag_list->fl_list, (clist_func) mailimap_flag_free, NULL);
     clist_free(flag_list->fl_list);
   }
-  free(flag_list);
+  carena_release(flag_list);
 }
 
 
@@ -1218,7 +1219,7 @@ mailimap_flag_perm_new(int fl_type, struct mailimap_flag * fl_flag)
 {
   struct mailimap_flag_perm * flag_perm;
 
-  flag_perm = malloc(sizeof(* flag_perm));
+  flag_perm = carena_malloc(sizeof(* flag_perm));
   if (flag_perm == NULL)
     return NULL;
 
@@ -1233,7 +1234,7 @@ void mailimap_flag_perm_free(struct mailimap_flag_perm * flag_perm)
 {
   if (flag_perm->fl_flag != NULL)
     mailimap_flag_free(flag_perm->fl_flag);
-  free(flag_perm);
+  carena_release(flag_perm);
 }
 
 
@@ -1247,7 +1248,7 @@ mailimap_greeting_new(int gr_type,
 {
   struct mailimap_greeting * greeting;
 
-  greeting = malloc(sizeof(* greeting));
+  greeting = carena_malloc(sizeof(* greeting));
   if (greeting == NULL)
     return NULL;
   greeting->gr_type = gr_type;
@@ -1274,7 +1275,7 @@ void mailimap_greeting_free(struct mailimap_greeting * greeting)
     mailimap_resp_cond_bye_free(greeting->gr_data.gr_bye);
     break;
   }
-  free(greeting);
+  carena_release(greeting);
 }
 
 
@@ -1294,7 +1295,7 @@ mailimap_header_list_new(clist * hdr_list)
 {
   struct mailimap_header_list * header_list;
 
-  header_list = malloc(sizeof(* header_list));
+  header_list = carena_malloc(sizeof(* header_list));
   if (header_list == NULL)
     return NULL;
 
@@ -1311,7 +1312,7 @@ mailimap_header_list_free(struct mailimap_header_list * header_list)
       (clist_func) mailimap_header_fld_name_free,
       NULL);
   clist_free(header_list->hdr_list);
-  free(header_list);
+  carena_release(header_list);
 }
 
 
@@ -1319,7 +1320,7 @@ mailimap_header_list_free(struct mailimap_header_list * header_list)
 LIBETPAN_EXPORT
 void mailimap_literal_free(char * literal)
 {
-  /*  free(literal); */
+  /*  carena_release(literal); */
   mmap_string_unref(literal);
 }
 
@@ -1339,7 +1340,7 @@ mailimap_status_info_new(int st_att, uint32_t st_value,
 {
   struct mailimap_status_info * info;
 
-  info = malloc(sizeof(* info));
+  info = carena_malloc(sizeof(* info));
   if (info == NULL)
     return NULL;
   info->st_att = st_att;
@@ -1355,7 +1356,7 @@ void mailimap_status_info_free(struct mailimap_status_info * info)
   if (info->st_ext_data != NULL) {
     mailimap_extension_data_free(info->st_ext_data);
   }
-  free(info);
+  carena_release(info);
 }
 
 
@@ -1367,7 +1368,7 @@ mailimap_mailbox_data_status_new(char * st_mailbox,
 {
   struct mailimap_mailbox_data_status * mb_data_status;
 
-  mb_data_status = malloc(sizeof(* mb_data_status));
+  mb_data_status = carena_malloc(sizeof(* mb_data_status));
   if (mb_data_status == NULL)
     return NULL;
   mb_data_status->st_mailbox = st_mailbox;
@@ -1394,7 +1395,7 @@ mailimap_mailbox_data_status_free(struct mailimap_mailbox_data_status * info)
       NULL);
     clist_free(info->st_info_list);
   }
-  free(info);
+  carena_release(info);
 }
 
 
@@ -1434,7 +1435,7 @@ mailimap_mailbox_data_new(int mbd_type, struct mailimap_flag_list * mbd_flags,
 {
   struct mailimap_mailbox_data * data;
 
-  data = malloc(sizeof(* data));
+  data = carena_malloc(sizeof(* data));
   if (data == NULL)
     return NULL;
 
@@ -1499,7 +1500,7 @@ mailimap_mailbox_data_free(struct mailimap_mailbox_data * mb_data)
       mailimap_extension_data_free(mb_data->mbd_data.mbd_extension);
     break;
   }
-  free(mb_data);
+  carena_release(mb_data);
 }
 
 
@@ -1513,7 +1514,7 @@ mailimap_mbx_list_flags_new(int mbf_type, clist * mbf_oflags,
 {
   struct mailimap_mbx_list_flags * mbx_list_flags;
 
-  mbx_list_flags = malloc(sizeof(* mbx_list_flags));
+  mbx_list_flags = carena_malloc(sizeof(* mbx_list_flags));
   if (mbx_list_flags == NULL)
     return NULL;
 
@@ -1533,7 +1534,7 @@ mailimap_mbx_list_flags_free(struct mailimap_mbx_list_flags * mbx_list_flags)
       NULL);
   clist_free(mbx_list_flags->mbf_oflags);
   
-  free(mbx_list_flags);
+  carena_release(mbx_list_flags);
 }
 
 
@@ -1543,7 +1544,7 @@ mailimap_mbx_list_oflag_new(int of_type, char * of_flag_ext)
 {
   struct mailimap_mbx_list_oflag * oflag;
 
-  oflag = malloc(sizeof(* oflag));
+  oflag = carena_malloc(sizeof(* oflag));
   if (oflag == NULL)
     return NULL;
 
@@ -1559,7 +1560,7 @@ mailimap_mbx_list_oflag_free(struct mailimap_mbx_list_oflag * oflag)
 {
   if (oflag->of_flag_ext != NULL)
     mailimap_flag_extension_free(oflag->of_flag_ext);
-  free(oflag);
+  carena_release(oflag);
 }
 
 
@@ -1571,7 +1572,7 @@ mailimap_mailbox_list_new(struct mailimap_mbx_list_flags * mbx_flags,
 {
   struct mailimap_mailbox_list * mb_list;
 
-  mb_list = malloc(sizeof(* mb_list));
+  mb_list = carena_malloc(sizeof(* mb_list));
   if (mb_list == NULL)
     return NULL;
   
@@ -1590,7 +1591,7 @@ mailimap_mailbox_list_free(struct mailimap_mailbox_list * mb_list)
     mailimap_mbx_list_flags_free(mb_list->mb_flag);
   if (mb_list->mb_name != NULL)
     mailimap_mailbox_free(mb_list->mb_name);
-  free(mb_list);
+  carena_release(mb_list);
 }
 
 
@@ -1602,7 +1603,7 @@ mailimap_media_basic_new(int med_type,
 {
   struct mailimap_media_basic * media_basic;
 
-  media_basic = malloc(sizeof(* media_basic));
+  media_basic = carena_malloc(sizeof(* media_basic));
   if (media_basic == NULL)
     return NULL;
   media_basic->med_type = med_type;
@@ -1618,7 +1619,7 @@ mailimap_media_basic_free(struct mailimap_media_basic * media_basic)
 {
   mailimap_string_free(media_basic->med_basic_type);
   mailimap_media_subtype_free(media_basic->med_subtype);
-  free(media_basic);
+  carena_release(media_basic);
 }
 
 
@@ -1645,7 +1646,7 @@ mailimap_message_data_new(uint32_t mdt_number, int mdt_type,
 {
   struct mailimap_message_data * msg_data;
 
-  msg_data = malloc(sizeof(* msg_data));
+  msg_data = carena_malloc(sizeof(* msg_data));
   if (msg_data == NULL) {
     return NULL;
   }
@@ -1663,7 +1664,7 @@ mailimap_message_data_free(struct mailimap_message_data * msg_data)
 {
   if (msg_data->mdt_msg_att != NULL)
     mailimap_msg_att_free(msg_data->mdt_msg_att);
-  free(msg_data);
+  carena_release(msg_data);
 }
 
 
@@ -1678,7 +1679,7 @@ mailimap_msg_att_item_new(int att_type,
 {
   struct mailimap_msg_att_item * item;
 
-  item = malloc(sizeof(* item));
+  item = carena_malloc(sizeof(* item));
   if (item == NULL)
     return item;
 
@@ -1713,7 +1714,7 @@ mailimap_msg_att_item_free(struct mailimap_msg_att_item * item)
     mailimap_extension_data_free(item->att_data.att_extension_data);
     break;
   }
-  free(item);
+  carena_release(item);
 }
 
 
@@ -1723,7 +1724,7 @@ mailimap_msg_att_new(clist * att_list)
 {
   struct mailimap_msg_att * msg_att;
 
-  msg_att = malloc(sizeof(* msg_att));
+  msg_att = carena_malloc(sizeof(* msg_att));
   if (msg_att == NULL)
     return NULL;
 
@@ -1739,7 +1740,7 @@ void mailimap_msg_att_free(struct mailimap_msg_att * msg_att)
   clist_foreach(msg_att->att_list,
       (clist_func) mailimap_msg_att_item_free, NULL);
   clist_free(msg_att->att_list);
-  free(msg_att);
+  carena_release(msg_att);
 }
 
 
@@ -1750,7 +1751,7 @@ mailimap_msg_att_dynamic_new(clist * att_list)
 {
   struct mailimap_msg_att_dynamic * msg_att_dyn;
 
-  msg_att_dyn = malloc(sizeof(* msg_att_dyn));
+  msg_att_dyn = carena_malloc(sizeof(* msg_att_dyn));
   if (msg_att_dyn == NULL)
     return NULL;
 
@@ -1769,7 +1770,7 @@ mailimap_msg_att_dynamic_free(struct mailimap_msg_att_dynamic * msg_att_dyn)
         NULL);
     clist_free(msg_att_dyn->att_list);
   }
-  free(msg_att_dyn);
+  carena_release(msg_att_dyn);
 }
 
 
@@ -1782,7 +1783,7 @@ mailimap_msg_att_body_section_new(struct mailimap_section * sec_section,
 {
   struct mailimap_msg_att_body_section * msg_att_body_section;
 
-  msg_att_body_section = malloc(sizeof(* msg_att_body_section));
+  msg_att_body_section = carena_malloc(sizeof(* msg_att_body_section));
   if (msg_att_body_section == NULL)
     return NULL;
 
@@ -1803,7 +1804,7 @@ mailimap_msg_att_body_section_free(struct mailimap_msg_att_body_section *
     mailimap_section_free(msg_att_body_section->sec_section);
   if (msg_att_body_section->sec_body_part != NULL)
     mailimap_nstring_free(msg_att_body_section->sec_body_part);
-  free(msg_att_body_section);
+  carena_release(msg_att_body_section);
 }
 
 
@@ -1878,7 +1879,7 @@ mailimap_msg_att_static_new(int att_type, struct mailimap_envelope * att_env,
 {
   struct mailimap_msg_att_static * item;
 
-  item = malloc(sizeof(* item));
+  item = carena_malloc(sizeof(* item));
   if (item == NULL)
     return FALSE;
 
@@ -1960,7 +1961,7 @@ mailimap_msg_att_static_free(struct mailimap_msg_att_static * item)
       mailimap_msg_att_body_section_free(item->att_data.att_body_section);
     break;
   }
-  free(item);
+  carena_release(item);
 }
  
 
@@ -1987,7 +1988,7 @@ mailimap_cont_req_or_resp_data_new(int rsp_type,
 {
   struct mailimap_cont_req_or_resp_data * cont_req_or_resp_data;
 
-  cont_req_or_resp_data = malloc(sizeof(* cont_req_or_resp_data));
+  cont_req_or_resp_data = carena_malloc(sizeof(* cont_req_or_resp_data));
   if (cont_req_or_resp_data == NULL)
     return NULL;
 
@@ -2019,7 +2020,7 @@ mailimap_cont_req_or_resp_data_free(struct mailimap_cont_req_or_resp_data *
       mailimap_response_data_free(cont_req_or_resp_data->rsp_data.rsp_resp_data);
     break;
   }
-  free(cont_req_or_resp_data);
+  carena_release(cont_req_or_resp_data);
 }
 
 
@@ -2032,7 +2033,7 @@ mailimap_response_new(clist * rsp_cont_req_or_resp_data_list,
 {
   struct mailimap_response * resp;
 
-  resp = malloc(sizeof(* resp));
+  resp = carena_malloc(sizeof(* resp));
   if (resp == NULL)
     return NULL;
 
@@ -2052,7 +2053,7 @@ mailimap_response_free(struct mailimap_response * resp)
     clist_free(resp->rsp_cont_req_or_resp_data_list);
   }
   mailimap_response_done_free(resp->rsp_resp_done);
-  free(resp);
+  carena_release(resp);
 }
 
 
@@ -2069,7 +2070,7 @@ mailimap_response_data_new(int rsp_type,
 {
   struct mailimap_response_data * resp_data;
 
-  resp_data = malloc(sizeof(* resp_data));
+  resp_data = carena_malloc(sizeof(* resp_data));
   if (resp_data == NULL)
     return NULL;
   resp_data->rsp_type = rsp_type;
@@ -2128,7 +2129,7 @@ mailimap_response_data_free(struct mailimap_response_data * resp_data)
       mailimap_extension_data_free(resp_data->rsp_data.rsp_extension_data);
     break;
   }
-  free(resp_data);
+  carena_release(resp_data);
 }
 
 
@@ -2141,7 +2142,7 @@ mailimap_response_done_new(int rsp_type,
 {
   struct mailimap_response_done * resp_done;
     
-  resp_done = malloc(sizeof(* resp_done));
+  resp_done = carena_malloc(sizeof(* resp_done));
   if (resp_done == NULL)
     return NULL;
 
@@ -2170,7 +2171,7 @@ void mailimap_response_done_free(struct mailimap_response_done *
     mailimap_response_fatal_free(resp_done->rsp_data.rsp_fatal);
     break;
   }
-  free(resp_done);
+  carena_release(resp_done);
 }
 
 LIBETPAN_EXPORT
@@ -2179,7 +2180,7 @@ mailimap_response_fatal_new(struct mailimap_resp_cond_bye * rsp_bye)
 {
   struct mailimap_response_fatal * resp_fatal;
 
-  resp_fatal = malloc(sizeof(* resp_fatal));
+  resp_fatal = carena_malloc(sizeof(* resp_fatal));
   if (resp_fatal == NULL)
     return NULL;
 
@@ -2192,7 +2193,7 @@ LIBETPAN_EXPORT
 void mailimap_response_fatal_free(struct mailimap_response_fatal * resp_fatal)
 {
   mailimap_resp_cond_bye_free(resp_fatal->rsp_bye);
-  free(resp_fatal);
+  carena_release(resp_fatal);
 }
 
 LIBETPAN_EXPORT
@@ -2202,7 +2203,7 @@ mailimap_response_tagged_new(char * rsp_tag,
 {
   struct mailimap_response_tagged * resp_tagged;
 
-  resp_tagged = malloc(sizeof(* resp_tagged));
+  resp_tagged = carena_malloc(sizeof(* resp_tagged));
   if (resp_tagged == NULL)
     return NULL;
 
@@ -2218,7 +2219,7 @@ mailimap_response_tagged_free(struct mailimap_response_tagged * tagged)
 {
   mailimap_tag_free(tagged->rsp_tag);
   mailimap_resp_cond_state_free(tagged->rsp_cond_state);
-  free(tagged);
+  carena_release(tagged);
 }
 
 
@@ -2230,7 +2231,7 @@ mailimap_resp_cond_auth_new(int rsp_type,
 {
   struct mailimap_resp_cond_auth * cond_auth;
 
-  cond_auth = malloc(sizeof(* cond_auth));
+  cond_auth = carena_malloc(sizeof(* cond_auth));
   if (cond_auth == NULL)
     return NULL;
 
@@ -2245,7 +2246,7 @@ void
 mailimap_resp_cond_auth_free(struct mailimap_resp_cond_auth * cond_auth)
 {
   mailimap_resp_text_free(cond_auth->rsp_text);
-  free(cond_auth);
+  carena_release(cond_auth);
 }
 
 
@@ -2256,7 +2257,7 @@ mailimap_resp_cond_bye_new(struct mailimap_resp_text * rsp_text)
 {
   struct mailimap_resp_cond_bye * cond_bye;
 
-  cond_bye = malloc(sizeof(* cond_bye));
+  cond_bye = carena_malloc(sizeof(* cond_bye));
   if (cond_bye == NULL)
     return NULL;
 
@@ -2271,7 +2272,7 @@ void
 mailimap_resp_cond_bye_free(struct mailimap_resp_cond_bye * cond_bye)
 {
   mailimap_resp_text_free(cond_bye->rsp_text);
-  free(cond_bye);
+  carena_release(cond_bye);
 }
 
 
@@ -2282,7 +2283,7 @@ mailimap_resp_cond_state_new(int rsp_type,
 {
   struct mailimap_resp_cond_state * cond_state;
 
-  cond_state = malloc(sizeof(* cond_state));
+  cond_state = carena_malloc(sizeof(* cond_state));
   if (cond_state == NULL)
     return NULL;
 
@@ -2297,7 +2298,7 @@ void
 mailimap_resp_cond_state_free(struct mailimap_resp_cond_state * cond_state)
 {
   mailimap_resp_text_free(cond_state->rsp_text);
-  free(cond_state);
+  carena_release(cond_state);
 }
 
 
@@ -2308,7 +2309,7 @@ mailimap_resp_text_new(struct mailimap_resp_text_code * rsp_code,
 {
   struct mailimap_resp_text * resp_text;
 
-  resp_text = malloc(sizeof(* resp_text));
+  resp_text = carena_malloc(sizeof(* resp_text));
   if (resp_text == NULL)
     return NULL;
 
@@ -2325,7 +2326,7 @@ void mailimap_resp_text_free(struct mailimap_resp_text * resp_text)
     mailimap_resp_text_code_free(resp_text->rsp_code);
   if (resp_text->rsp_text)
     mailimap_text_free(resp_text->rsp_text);
-  free(resp_text);
+  carena_release(resp_text);
 }
 
 
@@ -2342,7 +2343,7 @@ mailimap_resp_text_code_new(int rc_type, clist * rc_badcharset,
 {
   struct mailimap_resp_text_code * resp_text_code;
 
-  resp_text_code = malloc(sizeof(* resp_text_code));
+  resp_text_code = carena_malloc(sizeof(* resp_text_code));
   if (resp_text_code == NULL)
     return NULL;
 
@@ -2413,7 +2414,7 @@ mailimap_resp_text_code_free(struct mailimap_resp_text_code * resp_text_code)
       mailimap_extension_data_free(resp_text_code->rc_data.rc_ext_data);
     break;
   }
-  free(resp_text_code);
+  carena_release(resp_text_code);
 }
 
 
@@ -2423,7 +2424,7 @@ mailimap_section_new(struct mailimap_section_spec * sec_spec)
 {
   struct mailimap_section * section;
 
-  section = malloc(sizeof(* section));
+  section = carena_malloc(sizeof(* section));
   if (section == NULL)
     return NULL;
   
@@ -2437,7 +2438,7 @@ void mailimap_section_free(struct mailimap_section * section)
 {
   if (section->sec_spec != NULL)
     mailimap_section_spec_free(section->sec_spec);
-  free(section);
+  carena_release(section);
 }
 
 
@@ -2449,7 +2450,7 @@ mailimap_section_msgtext_new(int sec_type,
 {
   struct mailimap_section_msgtext * msgtext;
 
-  msgtext = malloc(sizeof(* msgtext));
+  msgtext = carena_malloc(sizeof(* msgtext));
   if (msgtext == NULL)
     return FALSE;
 
@@ -2465,7 +2466,7 @@ mailimap_section_msgtext_free(struct mailimap_section_msgtext * msgtext)
 {
   if (msgtext->sec_header_list != NULL)
     mailimap_header_list_free(msgtext->sec_header_list);
-  free(msgtext);
+  carena_release(msgtext);
 }
 
 
@@ -2475,7 +2476,7 @@ mailimap_section_part_new(clist * sec_id)
 {
   struct mailimap_section_part * section_part;
 
-  section_part = malloc(sizeof(* section_part));
+  section_part = carena_malloc(sizeof(* section_part));
   if (section_part == NULL)
     return NULL;
 
@@ -2491,7 +2492,7 @@ mailimap_section_part_free(struct mailimap_section_part * section_part)
   clist_foreach(section_part->sec_id,
       (clist_func) mailimap_number_alloc_free, NULL);
   clist_free(section_part->sec_id);
-  free(section_part);
+  carena_release(section_part);
 }
 
 
@@ -2504,7 +2505,7 @@ mailimap_section_spec_new(int sec_type,
 {
   struct mailimap_section_spec * section_spec;
 
-  section_spec = malloc(sizeof(* section_spec));
+  section_spec = carena_malloc(sizeof(* section_spec));
   if (section_spec == NULL)
     return NULL;
 
@@ -2540,7 +2541,7 @@ mailimap_section_spec_free(struct mailimap_section_spec * section_spec)
       mailimap_section_msgtext_free(section_spec->sec_data.sec_msgtext);
     break;
   }
-  free(section_spec);
+  carena_release(section_spec);
 }
 
 
@@ -2551,7 +2552,7 @@ mailimap_section_text_new(int sec_type,
 {
   struct mailimap_section_text * section_text;
   
-  section_text = malloc(sizeof(* section_text));
+  section_text = carena_malloc(sizeof(* section_text));
   if (section_text == NULL)
     return NULL;
 
@@ -2567,7 +2568,7 @@ mailimap_section_text_free(struct mailimap_section_text * section_text)
 {
   if (section_text->sec_msgtext != NULL)
     mailimap_section_msgtext_free(section_text->sec_msgtext);
-  free(section_text);
+  carena_release(section_text);
 }
 
 
@@ -2642,7 +2643,7 @@ mailimap_set_item_new(uint32_t set_first, uint32_t set_last)
 {
   struct mailimap_set_item * item;
 
-  item = malloc(sizeof(* item));
+  item = carena_malloc(sizeof(* item));
   if (item == NULL)
     return NULL;
 
@@ -2655,7 +2656,7 @@ mailimap_set_item_new(uint32_t set_first, uint32_t set_last)
 LIBETPAN_EXPORT
 void mailimap_set_item_free(struct mailimap_set_item * set_item)
 {
-  free(set_item);
+  carena_release(set_item);
 }
 
 LIBETPAN_EXPORT
@@ -2663,7 +2664,7 @@ struct mailimap_set * mailimap_set_new(clist * set_list)
 {
   struct mailimap_set * set;
 
-  set = malloc(sizeof(* set));
+  set = carena_malloc(sizeof(* set));
   if (set == NULL)
     return NULL;
 
@@ -2677,7 +2678,7 @@ void mailimap_set_free(struct mailimap_set * set)
 {
   clist_foreach(set->set_list, (clist_func) mailimap_set_item_free, NULL);
   clist_free(set->set_list);
-  free(set);
+  carena_release(set);
 }
 
 /* SEARCH with date key */
@@ -2689,7 +2690,7 @@ mailimap_date_new(int dt_day, int dt_month, int dt_year)
 {
   struct mailimap_date * date;
 
-  date = malloc(sizeof(* date));
+  date = carena_malloc(sizeof(* date));
   if (date == NULL)
     return NULL;
 
@@ -2703,7 +2704,7 @@ mailimap_date_new(int dt_day, int dt_month, int dt_year)
 LIBETPAN_EXPORT
 void mailimap_date_free(struct mailimap_date * date)
 {
-  free(date);
+  carena_release(date);
 }
 
 
@@ -2715,7 +2716,7 @@ mailimap_fetch_att_new(int att_type, struct mailimap_section * att_section,
 {
   struct mailimap_fetch_att * fetch_att;
 
-  fetch_att = malloc(sizeof(* fetch_att));
+  fetch_att = carena_malloc(sizeof(* fetch_att));
   if (fetch_att == NULL)
     return NULL;
   fetch_att->att_type = att_type;
@@ -2731,10 +2732,10 @@ LIBETPAN_EXPORT
 void mailimap_fetch_att_free(struct mailimap_fetch_att * fetch_att)
 {
   if (fetch_att->att_extension != NULL)
-    free(fetch_att->att_extension);
+    carena_release(fetch_att->att_extension);
   if (fetch_att->att_section != NULL)
     mailimap_section_free(fetch_att->att_section);
-  free(fetch_att);
+  carena_release(fetch_att);
 }
 
 
@@ -2747,7 +2748,7 @@ mailimap_fetch_type_new(int ft_type,
 {
   struct mailimap_fetch_type * fetch_type;
 
-  fetch_type = malloc(sizeof(* fetch_type));
+  fetch_type = carena_malloc(sizeof(* fetch_type));
   if (fetch_type == NULL)
     return NULL;
   fetch_type->ft_type = ft_type;
@@ -2776,7 +2777,7 @@ void mailimap_fetch_type_free(struct mailimap_fetch_type * fetch_type)
     clist_free(fetch_type->ft_data.ft_fetch_att_list);
     break;
   }
-  free(fetch_type);
+  carena_release(fetch_type);
 }
 
 
@@ -2789,7 +2790,7 @@ mailimap_store_att_flags_new(int fl_sign, int fl_silent,
 {
   struct mailimap_store_att_flags * store_att_flags;
 
-  store_att_flags = malloc(sizeof(* store_att_flags));
+  store_att_flags = carena_malloc(sizeof(* store_att_flags));
   if (store_att_flags == NULL)
     return NULL;
 
@@ -2805,7 +2806,7 @@ void mailimap_store_att_flags_free(struct mailimap_store_att_flags *
 				   store_att_flags)
 {
   mailimap_flag_list_free(store_att_flags->fl_flag_list);
-  free(store_att_flags);
+  carena_release(store_att_flags);
 }
 
 
@@ -2829,7 +2830,7 @@ mailimap_search_key_new(int sk_type,
 {
   struct mailimap_search_key * key;
 
-  key = malloc(sizeof(* key));
+  key = carena_malloc(sizeof(* key));
   if (key == NULL)
     return NULL;
   
@@ -2916,7 +2917,7 @@ mailimap_search_key_new_xgmthrid(uint64_t sk_xgmthrid)
 {
   struct mailimap_search_key * key;
   
-  key = malloc(sizeof(* key));
+  key = carena_malloc(sizeof(* key));
   if (key == NULL)
     return NULL;
   
@@ -2932,7 +2933,7 @@ mailimap_search_key_new_xgmmsgid(uint64_t sk_xgmmsgid)
 {
   struct mailimap_search_key * key;
   
-  key = malloc(sizeof(* key));
+  key = carena_malloc(sizeof(* key));
   if (key == NULL)
     return NULL;
   
@@ -2948,7 +2949,7 @@ mailimap_search_key_new_xgmraw(char * sk_xgmraw)
 {
   struct mailimap_search_key * key;
   
-  key = malloc(sizeof(* key));
+  key = carena_malloc(sizeof(* key));
   if (key == NULL)
     return NULL;
   
@@ -3039,7 +3040,7 @@ void mailimap_search_key_free(struct mailimap_search_key * key)
     break;
   }
   
-  free(key);
+  carena_release(key);
 }
 
 
@@ -3052,7 +3053,7 @@ mailimap_status_att_list_new(clist * att_list)
 {
   struct mailimap_status_att_list * status_att_list;
 
-  status_att_list = malloc(sizeof(* status_att_list));
+  status_att_list = carena_malloc(sizeof(* status_att_list));
   if (status_att_list == NULL)
     return NULL;
   status_att_list->att_list = att_list;
@@ -3064,9 +3065,9 @@ LIBETPAN_EXPORT
 void mailimap_status_att_list_free(struct mailimap_status_att_list *
 				   status_att_list)
 {
-  clist_foreach(status_att_list->att_list, (clist_func) free, NULL);
+  clist_foreach(status_att_list->att_list, (clist_func) carena_release, NULL);
   clist_free(status_att_list->att_list);
-  free(status_att_list);
+  carena_release(status_att_list);
 }
 
 
@@ -3081,7 +3082,7 @@ mailimap_selection_info_new(void)
 {
   struct mailimap_selection_info * sel_info;
 
-  sel_info = malloc(sizeof(* sel_info));
+  sel_info = carena_malloc(sizeof(* sel_info));
   if (sel_info == NULL)
     return NULL;
 
@@ -3112,7 +3113,7 @@ mailimap_selection_info_free(struct mailimap_selection_info * sel_info)
   if (sel_info->sel_flags)
     mailimap_flag_list_free(sel_info->sel_flags);
 
-  free(sel_info);
+  carena_release(sel_info);
 }
 
 LIBETPAN_EXPORT
@@ -3121,7 +3122,7 @@ mailimap_connection_info_new(void)
 {
   struct mailimap_connection_info * conn_info;
 
-  conn_info = malloc(sizeof(* conn_info));
+  conn_info = carena_malloc(sizeof(* conn_info));
   if (conn_info == NULL)
     return NULL;
   
@@ -3136,7 +3137,7 @@ mailimap_connection_info_free(struct mailimap_connection_info * conn_info)
 {
   if (conn_info->imap_capability != NULL)
     mailimap_capability_data_free(conn_info->imap_capability);
-  free(conn_info);
+  carena_release(conn_info);
 }
 
 LIBETPAN_EXPORT
@@ -3145,7 +3146,7 @@ mailimap_response_info_new(void)
 {
   struct mailimap_response_info * resp_info;
 
-  resp_info = malloc(sizeof(* resp_info));
+  resp_info = carena_malloc(sizeof(* resp_info));
   if (resp_info == NULL)
     goto err;
 
@@ -3174,6 +3175,7 @@ mailimap_response_info_new(void)
     goto free_expunged;
   resp_info->rsp_atom = NULL;
   resp_info->rsp_value = NULL;
+  resp_info->rsp_status_list = NULL;
   
   return resp_info;
 
@@ -3188,7 +3190,7 @@ mailimap_response_info_new(void)
  free_mb_list:
   clist_free(resp_info->rsp_mailbox_list);
  free:
-  free(resp_info);
+  carena_release(resp_info);
  err:
   return NULL;
 }
@@ -3197,12 +3199,12 @@ LIBETPAN_EXPORT
 void
 mailimap_response_info_free(struct mailimap_response_info * resp_info)
 {
-  free(resp_info->rsp_value);
-  free(resp_info->rsp_atom);
+  carena_release(resp_info->rsp_value);
+  carena_release(resp_info->rsp_atom);
   if (resp_info->rsp_alert != NULL)
-    free(resp_info->rsp_alert);
+    carena_release(resp_info->rsp_alert);
   if (resp_info->rsp_parse != NULL)
-    free(resp_info->rsp_parse);
+    carena_release(resp_info->rsp_parse);
   if (resp_info->rsp_badcharset != NULL) {
     clist_foreach(resp_info->rsp_badcharset,
         (clist_func) mailimap_astring_free, NULL);
@@ -3227,6 +3229,11 @@ mailimap_response_info_free(struct mailimap_response_info * resp_info)
     mailimap_mailbox_data_search_free(resp_info->rsp_search_result);
   if (resp_info->rsp_status != NULL)
     mailimap_mailbox_data_status_free(resp_info->rsp_status);
+  if (resp_info->rsp_status_list != NULL) {
+    clist_foreach(resp_info->rsp_status_list,
+        (clist_func) mailimap_mailbox_data_status_free, NULL);
+    clist_free(resp_info->rsp_status_list);
+  }
   if (resp_info->rsp_expunged != NULL) {
     clist_foreach(resp_info->rsp_expunged,
 		   (clist_func) mailimap_number_alloc_free, NULL);
@@ -3238,7 +3245,7 @@ mailimap_response_info_free(struct mailimap_response_info * resp_info)
     clist_free(resp_info->rsp_fetch_list);
   }
 
-  free(resp_info);
+  carena_release(resp_info);
 }
 
 
@@ -3262,7 +3269,7 @@ mailimap_parser_context_new(mailimap * session)
 {
   struct mailimap_parser_context * ctx;
 
-  ctx = malloc(sizeof(* ctx));
+  ctx = carena_malloc(sizeof(* ctx));
   if (ctx == NULL)
     goto err;
 
@@ -3274,6 +3281,7 @@ mailimap_parser_context_new(mailimap * session)
   ctx->msg_body_parse_in_progress = false;
   ctx->msg_body_section = NULL;
   ctx->msg_body_att_type = 0;
+  ctx->arena = session->imap_arena;
 
   return ctx;
 
@@ -3285,5 +3293,5 @@ LIBETPAN_EXPORT
 void
 mailimap_parser_context_free(struct mailimap_parser_context * ctx)
 {
-  free(ctx);
+  carena_release(ctx);
 }
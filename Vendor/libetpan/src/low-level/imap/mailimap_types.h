@@ -3394,6 +3394,8 @@ struct mailimap {
   int is_163_workaround_enabled;
   int is_rambler_workaround_enabled;
   int is_qip_workaround_enabled;
+
+  struct carena_s * imap_arena;
 };
 
 
@@ -3492,6 +3494,9 @@ mailimap_selection_info_free(struct mailimap_selection_info * sel_info);
 
   - status is a STATUS response
 
+  - status_list is the list of the STATUS responses received before the
+    last one, when a command returns several of them (LIST-STATUS)
+
   - expunged is a list of message numbers
 
   - fetch_list is a list of fetch response
@@ -3511,6 +3516,7 @@ struct mailimap_response_info {
   clist * rsp_extension_list; /* list of (struct mailimap_extension_data *) */
   char * rsp_atom;
   char * rsp_value;
+  clist * rsp_status_list; /* list of (struct mailimap_mailbox_data_status *) */
 };
 
 LIBETPAN_EXPORT
@@ -3584,6 +3590,8 @@ struct mailimap_parser_context {
   struct mailimap_msg_att_body_section * msg_body_section;
   int msg_body_att_type;
   bool msg_body_parse_in_progress;
+
+  struct carena_s * arena;
 };
 
 LIBETPAN_EXPORT
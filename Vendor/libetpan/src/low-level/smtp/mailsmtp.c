@@ -420,6 +420,8 @@ int mailsmtp_rcpt(mailsmtp * session, const char * to)
   return mailesmtp_rcpt(session, to, 0, NULL);
 }
 
+static int data_response_error(int r);
+
 int mailsmtp_data(mailsmtp * session)
 {
   int r;
@@ -431,6 +433,11 @@ int mailsmtp_data(mailsmtp * session)
     return MAILSMTP_ERROR_STREAM;
   r = read_response(session);
 
+  return data_response_error(r);
+}
+
+static int data_response_error(int r)
+{
   switch (r) {
   case 354:
     return MAILSMTP_NO_ERROR;
@@ -826,13 +833,11 @@ int mailesmtp_mail(mailsmtp * session,
 	return mailesmtp_mail_size(session, from, return_full, envid, 0);
 }
 
-int mailesmtp_mail_size(mailsmtp * session,
-		    const char * from,
-		    int return_full,
-		    const char * envid, size_t size)
+static int mail_response_error(int r);
+
+static void mail_size_command(mailsmtp * session, char * command,
+    const char * from, int return_full, const char * envid, size_t size)
 {
-  int r;
-  char command[SMTP_STRING_SIZE];
   char ret_param[SMTP_STRING_SIZE];
   char envid_param[SMTP_STRING_SIZE];
   char size_param[SMTP_STRING_SIZE];
@@ -851,12 +856,28 @@ int mailesmtp_mail_size(mailsmtp * session,
   }
   snprintf(command, SMTP_STRING_SIZE, "MAIL FROM:<%s>%s%s%s\r\n",
     from, ret_param, envid_param, size_param);
+}
+
+int mailesmtp_mail_size(mailsmtp * session,
+		    const char * from,
+		    int return_full,
+		    const char * envid, size_t size)
+{
+  int r;
+  char command[SMTP_STRING_SIZE];
+
+  mail_size_command(session, command, from, return_full, envid, size);
 
   r = send_command(session, command);
   if (r == -1)
     return MAILSMTP_ERROR_STREAM;
   r = read_response(session);
 
+  return mail_response_error(r);
+}
+
+static int mail_response_error(int r)
+{
   switch (r) {
   case 250:
     return MAILSMTP_NO_ERROR;
@@ -887,13 +908,11 @@ int mailesmtp_mail_size(mailsmtp * session,
   }
 }
 
-int mailesmtp_rcpt(mailsmtp * session,
-		    const char * to,
-		    int notify,
-		    const char * orcpt)
+static int rcpt_response_error(int r);
+
+static void rcpt_command(mailsmtp * session, char * command,
+    const char * to, int notify, const char * orcpt)
 {
-  int r;
-  char command[SMTP_STRING_SIZE];
   char notify_str[30] = "";
   char notify_info_str[30] = "";
 
@@ -919,12 +938,28 @@ int mailesmtp_rcpt(mailsmtp * session,
 	     to, notify_str, orcpt);
   else
     snprintf(command, SMTP_STRING_SIZE, "RCPT TO:<%s>%s\r\n", to, notify_str);
+}
+
+int mailesmtp_rcpt(mailsmtp * session,
+		    const char * to,
+		    int notify,
+		    const char * orcpt)
+{
+  int r;
+  char command[SMTP_STRING_SIZE];
+
+  rcpt_command(session, command, to, notify, orcpt);
 
   r = send_command(session, command);
   if (r == -1)
     return MAILSMTP_ERROR_STREAM;
   r = read_response(session);
 
+  return rcpt_response_error(r);
+}
+
+static int rcpt_response_error(int r)
+{
   switch (r) {
   case 250:
     return MAILSMTP_NO_ERROR;
@@ -962,6 +997,58 @@ int mailesmtp_rcpt(mailsmtp * session,
   }
 }
 
+/*
+  sends MAIL FROM, every RCPT TO and DATA in a single write, as allowed
+  by the PIPELINING extension (RFC 2920), then reads the responses in
+  order. On success, the server is waiting for the message data.
+  Reading stops at the first error so that the failing response is kept
+  in session->response; the session should then be closed.
+*/
+
+int mailesmtp_mail_rcpt_data(mailsmtp * session,
+    const char * from,
+    int return_full,
+    const char * envid, size_t size,
+    clist * addresses)
+{
+  char command[SMTP_STRING_SIZE];
+  clistiter * cur;
+  int r;
+
+  mailstream_set_privacy(session->stream, 1);
+
+  mail_size_command(session, command, from, return_full, envid, size);
+  if (mailstream_write(session->stream, command, strlen(command)) == -1)
+    return MAILSMTP_ERROR_STREAM;
+
+  for(cur = clist_begin(addresses) ; cur != NULL ; cur = clist_next(cur)) {
+    struct esmtp_address * addr;
+
+    addr = clist_content(cur);
+    rcpt_command(session, command, addr->address, addr->notify, addr->orcpt);
+    if (mailstream_write(session->stream, command, strlen(command)) == -1)
+      return MAILSMTP_ERROR_STREAM;
+  }
+
+  snprintf(command, SMTP_STRING_SIZE, "DATA\r\n");
+  if (mailstream_write(session->stream, command, strlen(command)) == -1)
+    return MAILSMTP_ERROR_STREAM;
+  if (mailstream_flush(session->stream) == -1)
+    return MAILSMTP_ERROR_STREAM;
+
+  r = mail_response_error(read_response(session));
+  if (r != MAILSMTP_NO_ERROR)
+    return r;
+
+  for(cur = clist_begin(addresses) ; cur != NULL ; cur = clist_next(cur)) {
+    r = rcpt_response_error(read_response(session));
+    if (r != MAILSMTP_NO_ERROR)
+      return r;
+  }
+
+  return data_response_error(read_response(session));
+}
+
 int auth_map_errors(int err)
 {
   switch (err) {
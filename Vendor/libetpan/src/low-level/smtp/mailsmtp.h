@@ -149,6 +149,13 @@ int mailesmtp_rcpt(mailsmtp * session,
 		    int notify,
 		    const char * orcpt);
 
+LIBETPAN_EXPORT
+int mailesmtp_mail_rcpt_data(mailsmtp * session,
+    const char * from,
+    int return_full,
+    const char * envid, size_t size,
+    clist * addresses);
+
 LIBETPAN_EXPORT
 int mailesmtp_starttls(mailsmtp * session);
 
@@ -86,6 +86,9 @@ static int mailesmtp_send_mail(mailsmtp * session,
     }
   }
   
+  if ((session->esmtp & MAILSMTP_ESMTP_PIPELINING) != 0)
+    return mailesmtp_mail_rcpt_data(session, from, return_full, envid, size, addresses);
+
   r = mailesmtp_mail_size(session, from, return_full, envid, size);
   if (r != MAILSMTP_NO_ERROR)
     return r;
@@ -135,6 +135,7 @@ namespace mailcore {
         IMAPCapabilityXOAuth2,
         IMAPCapabilityXYMHighestModseq,
         IMAPCapabilityGmail,
+        IMAPCapabilityListStatus,
     };
     
     enum POPCapability {
@@ -1,6 +1,7 @@
 #include "MCAutoreleasePool.h"
 
-#include <libetpan/libetpan.h>
+#include <stdlib.h>
+#include <atomic>
 
 #include "MCString.h"
 #include "MCLog.h"
@@ -8,25 +9,79 @@
 
 using namespace mailcore;
 
-pthread_key_t AutoreleasePool::autoreleasePoolStackKey;
+// 4KB per chunk on 64-bit platforms.
+#define CHUNK_CAPACITY 510
+#define MAX_SPARE_CHUNKS 4
 
-void AutoreleasePool::init()
+namespace mailcore {
+    struct AutoreleasePoolChunk {
+        AutoreleasePoolChunk * next;
+        unsigned int count;
+        Object * objects[CHUNK_CAPACITY];
+    };
+}
+
+// Pools form a per-thread stack linked through mPreviousPool. Chunks of drained
+// pools are kept for reuse so that short-lived pools don't hit malloc.
+struct AutoreleasePoolThreadState {
+    AutoreleasePool * currentPool = NULL;
+    AutoreleasePoolChunk * spareChunks = NULL;
+    unsigned int spareChunksCount = 0;
+    
+    ~AutoreleasePoolThreadState()
+    {
+        if (currentPool != NULL) {
+            MCLog("some autoreleasepool have not been released\n");
+        }
+        while (spareChunks != NULL) {
+            AutoreleasePoolChunk * next = spareChunks->next;
+            free(spareChunks);
+            spareChunks = next;
+        }
+    }
+};
+
+static thread_local AutoreleasePoolThreadState threadState;
+static std::atomic<unsigned int> poolHighWaterMark(0);
+
+static AutoreleasePoolChunk * takeChunk()
 {
-    static pthread_once_t once = PTHREAD_ONCE_INIT;
-    pthread_once(&once, initAutoreleasePoolStackKey);
+    AutoreleasePoolChunk * chunk = threadState.spareChunks;
+    if (chunk != NULL) {
+        threadState.spareChunks = chunk->next;
+        threadState.spareChunksCount --;
+    }
+    else {
+        chunk = (AutoreleasePoolChunk *) malloc(sizeof(* chunk));
+    }
+    chunk->next = NULL;
+    chunk->count = 0;
+    return chunk;
+}
+
+static void recycleChunk(AutoreleasePoolChunk * chunk)
+{
+    if (threadState.spareChunksCount >= MAX_SPARE_CHUNKS) {
+        free(chunk);
+        return;
+    }
+    chunk->next = threadState.spareChunks;
+    threadState.spareChunks = chunk;
+    threadState.spareChunksCount ++;
 }
 
 AutoreleasePool::AutoreleasePool()
 {
-    mPoolObjects = carray_new(4);
+    mFirstChunk = NULL;
+    mLastChunk = NULL;
+    mCount = 0;
     
 #if __APPLE__
     mAppleAutoreleasePool = createAppleAutoreleasePool();
 #endif
     
-    unsigned int idx;
-    carray * stack = createAutoreleasePoolStackIfNeeded();
-    carray_add(stack, this, &idx);
+    mPreviousPool = threadState.currentPool;
+    threadState.currentPool = this;
 }
 
 AutoreleasePool::~AutoreleasePool()
@@ -35,64 +90,45 @@ AutoreleasePool::~AutoreleasePool()
     releaseAppleAutoreleasePool(mAppleAutoreleasePool);
 #endif
     
-    carray * stack = createAutoreleasePoolStackIfNeeded();
-    carray_delete_slow(stack, carray_count(stack) - 1);
+    // Pop first: objects released below that autorelease go to the parent pool.
+    threadState.currentPool = mPreviousPool;
     
-    unsigned int count = carray_count(mPoolObjects);
-    for(unsigned int i = 0 ; i < count ; i ++) {
-        Object * obj = (Object *) carray_get(mPoolObjects, i);
-        obj->release();
-    }
-    carray_free(mPoolObjects);
-}
-
-carray * AutoreleasePool::createAutoreleasePoolStackIfNeeded()
-{
-    init();
-    carray * stack = (carray *) pthread_getspecific(autoreleasePoolStackKey);
-    if (stack != NULL) {
-        return stack;
+    AutoreleasePoolChunk * chunk = mFirstChunk;
+    while (chunk != NULL) {
+        Object ** objects = chunk->objects;
+        for(unsigned int i = 0 ; i < chunk->count ; i ++) {
+            objects[i]->release();
+        }
+        AutoreleasePoolChunk * next = chunk->next;
+        recycleChunk(chunk);
+        chunk = next;
     }
     
-    stack = carray_new(4);
-    pthread_setspecific(autoreleasePoolStackKey, stack);
-    
-    return stack;
-}
-
-void AutoreleasePool::destroyAutoreleasePoolStack(void * value)
-{
-    carray * stack = (carray *) value;
-    if (carray_count(stack) != 0) {
-        MCLog("some autoreleasepool have not been released\n");
+    unsigned int highWaterMark = poolHighWaterMark.load(std::memory_order_relaxed);
+    while ((mCount > highWaterMark) &&
+           !poolHighWaterMark.compare_exchange_weak(highWaterMark, mCount, std::memory_order_relaxed)) {
     }
-    carray_free(stack);
-}
-
-void AutoreleasePool::initAutoreleasePoolStackKey()
-{
-    pthread_key_create(&autoreleasePoolStackKey, destroyAutoreleasePoolStack);
 }
 
 AutoreleasePool * AutoreleasePool::currentAutoreleasePool()
 {
-    init();
-    carray * stack;
-    stack = createAutoreleasePoolStackIfNeeded();
-    if (carray_count(stack) == 0) {
-        //fprintf(stderr, "no current autoreleasepool\n");
-        return NULL;
-    }
-
-    AutoreleasePool * pool;
-    pool = (AutoreleasePool *) carray_get(stack, carray_count(stack) - 1);
-    return pool;
+    return threadState.currentPool;
 }
 
 void AutoreleasePool::add(Object * obj)
 {
-    unsigned int idx;
-    carray_add(mPoolObjects, obj, &idx);
+    if ((mLastChunk == NULL) || (mLastChunk->count == CHUNK_CAPACITY)) {
+        AutoreleasePoolChunk * chunk = takeChunk();
+        if (mLastChunk == NULL) {
+            mFirstChunk = chunk;
+        }
+        else {
+            mLastChunk->next = chunk;
+        }
+        mLastChunk = chunk;
+    }
+    mLastChunk->objects[mLastChunk->count ++] = obj;
+    mCount ++;
 }
 
 void AutoreleasePool::autorelease(Object * obj)
@@ -105,17 +141,29 @@ void AutoreleasePool::autorelease(Object * obj)
     pool->add(obj);
 }
 
+unsigned int AutoreleasePool::highWaterMark()
+{
+    return poolHighWaterMark.load(std::memory_order_relaxed);
+}
+
+void AutoreleasePool::resetHighWaterMark()
+{
+    poolHighWaterMark.store(0, std::memory_order_relaxed);
+}
+
 String * AutoreleasePool::description()
 {
     String * result = String::string();
     result->appendUTF8Format("<%p:%p ", className(), this);
-    unsigned int count = carray_count(mPoolObjects);
-    for(unsigned int i = 0 ; i < count ; i ++) {
-        Object * obj = (Object *) carray_get(mPoolObjects, i);
-        if (i != 0) {
-            result->appendUTF8Characters(" ");
+    bool first = true;
+    for(AutoreleasePoolChunk * chunk = mFirstChunk ; chunk != NULL ; chunk = chunk->next) {
+        for(unsigned int i = 0 ; i < chunk->count ; i ++) {
+            if (!first) {
+                result->appendUTF8Characters(" ");
+            }
+            first = false;
+            result->appendString(chunk->objects[i]->description());
         }
-        result->appendString(obj->description());
     }
     result->appendUTF8Characters(">");
     
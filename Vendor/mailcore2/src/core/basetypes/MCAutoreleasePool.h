@@ -3,14 +3,13 @@
 #define MAILCORE_MCAUTORELEASEPOOL_H
 
 #include <MailCore/MCObject.h>
-#include <pthread.h>
 
 #ifdef __cplusplus
 
-typedef struct carray_s carray;
-
 namespace mailcore {
     
+    struct AutoreleasePoolChunk;
+    
     class MAILCORE_EXPORT AutoreleasePool : public Object {
     public:
         AutoreleasePool();
@@ -18,18 +17,21 @@ namespace mailcore {
         
         static void autorelease(Object * obj);
         
+        // Largest number of objects any pool has held when it was drained.
+        // A high value points at a loop that needs its own inner pool.
+        static unsigned int highWaterMark();
+        static void resetHighWaterMark();
+        
     public: // subclass behavior
         virtual String * description();
         
     private:
-        static void init();
-        static pthread_key_t autoreleasePoolStackKey;
-        carray * mPoolObjects;
-        static carray * createAutoreleasePoolStackIfNeeded();
-        static void destroyAutoreleasePoolStack(void *);
-        static void initAutoreleasePoolStackKey();
+        AutoreleasePool * mPreviousPool;
+        AutoreleasePoolChunk * mFirstChunk;
+        AutoreleasePoolChunk * mLastChunk;
+        unsigned int mCount;
         static AutoreleasePool * currentAutoreleasePool();
-        virtual void add(Object * obj);
+        void add(Object * obj);
 #ifdef __APPLE__
         void * mAppleAutoreleasePool;
         static void * createAppleAutoreleasePool();
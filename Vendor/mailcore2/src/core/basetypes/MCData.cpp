@@ -278,25 +278,41 @@ String * Data::stringWithDetectedCharset()
     return result;
 }
 
-static String * normalizeCharset(String * charset)
+static HashMap * charsetAliases = NULL;
+
+static void initCharsetAliases()
 {
-    if ((charset->caseInsensitiveCompare(MCSTR("iso-2022-jp")) == 0) ||
-    (charset->caseInsensitiveCompare(MCSTR("iso-2022-jp-2")) == 0)) {
-        charset = MCSTR("iso-2022-jp-2");
-    }
-    else if (charset->caseInsensitiveCompare(MCSTR("ks_c_5601-1987")) == 0) {
-        charset = MCSTR("euckr");
-    }
-    else if ((charset->caseInsensitiveCompare(MCSTR("iso-8859-8-i")) == 0) ||
-    (charset->caseInsensitiveCompare(MCSTR("iso-8859-8-e")) == 0)) {
-        charset = MCSTR("iso-8859-8");
-    }
-    else if ((charset->caseInsensitiveCompare(MCSTR("GB2312")) == 0) ||
-    (charset->caseInsensitiveCompare(MCSTR("GB_2312-80")) == 0)) {
-        charset = MCSTR("GBK");
+    static const char * aliases[][2] = {
+        {"iso-2022-jp", "iso-2022-jp-2"},
+        {"iso-2022-jp-2", "iso-2022-jp-2"},
+        {"ks_c_5601-1987", "euckr"},
+        {"iso-8859-8-i", "iso-8859-8"},
+        {"iso-8859-8-e", "iso-8859-8"},
+        {"gb2312", "gbk"},
+        {"gb_2312-80", "gbk"},
+    };
+    
+    charsetAliases = new HashMap();
+    for(unsigned int i = 0 ; i < sizeof(aliases) / sizeof(aliases[0]) ; i ++) {
+        String * alias = new String(aliases[i][0]);
+        String * name = new String(aliases[i][1]);
+        charsetAliases->setObjectForKey(alias, name);
+        MC_SAFE_RELEASE(alias);
+        MC_SAFE_RELEASE(name);
     }
+}
+
+static String * normalizeCharset(String * charset)
+{
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    pthread_once(&once, initCharsetAliases);
     
-    return charset->lowercaseString();
+    charset = charset->lowercaseString();
+    String * normalized = (String *) charsetAliases->objectForKey(charset);
+    if (normalized != NULL) {
+        return normalized;
+    }
+    return charset;
 }
 
 String * Data::stringWithCharset(const char * charset)
@@ -399,6 +415,31 @@ static bool isHintCharsetValid(String * hintCharset)
     return false;
 }
 
+// Plain 7-bit text, without the NULs of UTF-16 or the escape sequences of
+// ISO-2022 charsets.
+static bool isPlainASCII(const char * bytes, unsigned int length)
+{
+    for(unsigned int i = 0 ; i < length ; i ++) {
+        unsigned char c = (unsigned char) bytes[i];
+        if ((c >= 0x80) || (c == 0x1B) || (c == 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool isASCIIHintCharset(String * hintCharset)
+{
+    static const char * names[] = {"us-ascii", "utf-8", "iso-8859-1", "windows-1252"};
+    const char * name = hintCharset->UTF8Characters();
+    for(unsigned int i = 0 ; i < sizeof(names) / sizeof(names[0]) ; i ++) {
+        if (strcmp(name, names[i]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
 String * Data::stringWithDetectedCharset(String * hintCharset, bool isHTML)
 {
     String * result;
@@ -407,6 +448,15 @@ String * Data::stringWithDetectedCharset(String * hintCharset, bool isHTML)
     if (hintCharset != NULL) {
         hintCharset = normalizeCharset(hintCharset);
     }
+    
+    // Plain ASCII decodes the same with any charset detection could pick or an
+    // ASCII hint could name, so skip the detector.
+    if (((hintCharset == NULL) || isASCIIHintCharset(hintCharset)) && isPlainASCII(bytes(), length())) {
+        result = stringWithCharset("us-ascii");
+        if (result != NULL) {
+            return result;
+        }
+    }
     if (isHintCharsetValid(hintCharset)) {
         charset = hintCharset;
     }
@@ -456,6 +506,37 @@ String * Data::stringWithDetectedCharset(String * hintCharset, bool isHTML)
     return result;
 }
 
+#if !USE_UCHARDET
+static pthread_key_t charsetDetectorKey;
+
+static void destroyCharsetDetector(void * value)
+{
+    ucsdet_close((UCharsetDetector *) value);
+}
+
+static void initCharsetDetectorKey()
+{
+    pthread_key_create(&charsetDetectorKey, destroyCharsetDetector);
+}
+
+// ucsdet_open() instantiates every recognizer, so each thread reuses one detector.
+static UCharsetDetector * cachedCharsetDetector(UErrorCode * pErr)
+{
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    pthread_once(&once, initCharsetDetectorKey);
+    
+    UCharsetDetector * detector = (UCharsetDetector *) pthread_getspecific(charsetDetectorKey);
+    if (detector == NULL) {
+        detector = ucsdet_open(pErr);
+        if (detector == NULL) {
+            return NULL;
+        }
+        pthread_setspecific(charsetDetectorKey, detector);
+    }
+    return detector;
+}
+#endif
+
 String * Data::charsetWithFilteredHTMLWithoutHint(bool filterHTML)
 {
 #if !USE_UCHARDET
@@ -465,19 +546,20 @@ String * Data::charsetWithFilteredHTMLWithoutHint(bool filterHTML)
     const char * cName;
     String * result;
     
-    detector = ucsdet_open(&err);
+    detector = cachedCharsetDetector(&err);
+    if (detector == NULL) {
+        return NULL;
+    }
     ucsdet_setText(detector, bytes(), length(), &err);
     ucsdet_enableInputFilter(detector, filterHTML);
     match = ucsdet_detect(detector, &err);
     if (match == NULL) {
-        ucsdet_close(detector);
         return NULL;
     }
     
     cName = ucsdet_getName(match, &err);
     
     result = String::stringWithUTF8Characters(cName);
-    ucsdet_close(detector);
     
     return result;
 #else
@@ -511,16 +593,17 @@ String * Data::charsetWithFilteredHTML(bool filterHTML, String * hintCharset)
     
     hintCharset = hintCharset->lowercaseString();
     
-    detector = ucsdet_open(&err);
+    detector = cachedCharsetDetector(&err);
+    if (detector == NULL) {
+        return hintCharset;
+    }
     ucsdet_setText(detector, bytes(), length(), &err);
     ucsdet_enableInputFilter(detector, filterHTML);
     matches = ucsdet_detectAll(detector,  &matchesCount, &err);
     if (matches == NULL) {
-        ucsdet_close(detector);
         return hintCharset;
     }
     if (matchesCount == 0) {
-        ucsdet_close(detector);
         return hintCharset;
     }
     
@@ -560,7 +643,6 @@ String * Data::charsetWithFilteredHTML(bool filterHTML, String * hintCharset)
             }
         }
     }
-    ucsdet_close(detector);
     
     if (result == NULL)
         result = hintCharset;
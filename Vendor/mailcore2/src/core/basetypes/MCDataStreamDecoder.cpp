@@ -60,26 +60,27 @@ ErrorCode DataStreamDecoder::appendData(Data * data)
 
 ErrorCode DataStreamDecoder::flushData()
 {
-    if (mRemainingData == NULL || mRemainingData->length() == 0) {
-        return ErrorNone;
-    }
-
-    Data * unused = NULL;
-    Data * decodedData = MCDecodeData(mRemainingData, mEncoding, false, &unused);
-
-    ErrorCode errorCode = appendDecodedData(decodedData);
+    if (mRemainingData != NULL && mRemainingData->length() > 0) {
+        Data * unused = NULL;
+        Data * decodedData = MCDecodeData(mRemainingData, mEncoding, false, &unused);
 
-    if (errorCode == ErrorNone) {
-        if (mFile != NULL) {
-            if (fclose(mFile) != 0) {
-                return ErrorFile;
-            }
+        ErrorCode errorCode = appendDecodedData(decodedData);
+        if (errorCode != ErrorNone) {
+            return errorCode;
         }
 
         MC_SAFE_RELEASE(mRemainingData);
     }
 
-    return errorCode;
+    if (mFile != NULL) {
+        int r = fclose(mFile);
+        mFile = NULL;
+        if (r != 0) {
+            return ErrorFile;
+        }
+    }
+
+    return ErrorNone;
 }
 
 ErrorCode DataStreamDecoder::appendDecodedData(Data * decodedData)
@@ -94,7 +95,9 @@ ErrorCode DataStreamDecoder::appendDecodedData(Data * decodedData)
 
     if (mFile == NULL) {
 #ifdef _MSC_VER
-		fopen_s(&mFile, mFilename->fileSystemRepresentation(), "wb");
+        if (_wfopen_s(&mFile, reinterpret_cast<const wchar_t *>(mFilename->unicodeCharacters()), L"wb") != 0) {
+            mFile = NULL;
+        }
 #else
 		mFile = fopen(mFilename->fileSystemRepresentation(), "wb");
 #endif
@@ -20,7 +20,6 @@
 #include "MCMainThread.h"
 #include "MCLog.h"
 #include "MCHashMap.h"
-#include "MCLock.h"
 
 using namespace mailcore;
 
@@ -33,48 +32,41 @@ Object::Object()
 
 Object::~Object()
 {
-    pthread_mutex_destroy(&mLock);
 }
 
 void Object::init()
 {
-    pthread_mutex_init(&mLock, NULL);
-    mCounter = 1;
+    mCounter.store(1, std::memory_order_relaxed);
 }
 
 int Object::retainCount()
 {
-    MC_LOCK(&mLock);
-    int value = mCounter;
-    MC_UNLOCK(&mLock);
-    
-    return value;
+    return mCounter.load(std::memory_order_relaxed);
 }
 
 Object * Object::retain()
 {
-    MC_LOCK(&mLock);
-    mCounter ++;
-    MC_UNLOCK(&mLock);
+    // The caller already owns a reference, so no ordering is needed to take another one.
+    mCounter.fetch_add(1, std::memory_order_relaxed);
     return this;
 }
 
 void Object::release()
 {
-    bool shouldRelease = false;
-    
-    MC_LOCK(&mLock);
-    mCounter --;
-    if (mCounter == 0) {
-        shouldRelease = true;
-    }
-    if (mCounter < 0) {
+    // Release ordering publishes this thread's writes to whichever thread drops
+    // the last reference; that thread synchronizes with them before deleting.
+    int previous = mCounter.fetch_sub(1, std::memory_order_release);
+    if (previous <= 0) {
         MCLog("release too much %p %s", this, MCUTF8(className()));
         MCAssert(0);
+        return;
+    }
+    if (previous != 1) {
+        return;
     }
-    MC_UNLOCK(&mLock);
+    std::atomic_thread_fence(std::memory_order_acquire);
 
-    if (shouldRelease && !zombieEnabled) {
+    if (!zombieEnabled) {
         //int status;
         //char * unmangled = abi::__cxa_demangle(typeid(* this).name(), NULL, NULL, &status);
         //MCLog("dealloc %p %s", this, unmangled);
@@ -12,6 +12,8 @@
 
 #ifdef __cplusplus
 
+#include <atomic>
+
 namespace mailcore {
     
     extern bool zombieEnabled;
@@ -57,8 +59,7 @@ namespace mailcore {
     public: // private
         
     private:
-        pthread_mutex_t mLock;
-        int mCounter;
+        std::atomic<int> mCounter;
         void init();
         static void initObjectConstructors();
     };
@@ -837,6 +837,7 @@ static char * extract_subject(char * str, int keep_bracket)
 String::String(const UChar * unicodeChars)
 {
     mUnicodeChars = NULL;
+    mUTF8Cache = NULL;
     reset();
     if (unicodeChars != NULL) {
         allocate(u_strlen(unicodeChars), true);
@@ -847,6 +848,7 @@ String::String(const UChar * unicodeChars)
 String::String(const UChar * unicodeChars, unsigned int length)
 {
     mUnicodeChars = NULL;
+    mUTF8Cache = NULL;
     reset();
     allocate(length, true);
     appendCharactersLength(unicodeChars, length);
@@ -855,6 +857,7 @@ String::String(const UChar * unicodeChars, unsigned int length)
 String::String(const char * UTF8Characters)
 {
     mUnicodeChars = NULL;
+    mUTF8Cache = NULL;
     reset();
     if (UTF8Characters != NULL) {
         allocate((unsigned int) strlen(UTF8Characters), true);
@@ -865,6 +868,7 @@ String::String(const char * UTF8Characters)
 String::String(String * otherString)
 {
     mUnicodeChars = NULL;
+    mUTF8Cache = NULL;
     reset();
     appendString(otherString);
 }
@@ -872,6 +876,7 @@ String::String(String * otherString)
 String::String(Data * data, const char * charset)
 {
     mUnicodeChars = NULL;
+    mUTF8Cache = NULL;
     reset();
     appendBytes(data->bytes(), data->length(), charset);
 }
@@ -879,6 +884,7 @@ String::String(Data * data, const char * charset)
 String::String(const char * bytes, unsigned int length, const char * charset)
 {
     mUnicodeChars = NULL;
+    mUTF8Cache = NULL;
     reset();
     allocate(length, true);
     if (charset == NULL) {
@@ -988,6 +994,7 @@ void String::appendCharactersLength(const UChar * unicodeCharacters, unsigned in
     if (unicodeCharacters == NULL) {
         return;
     }
+    invalidateUTF8Cache();
     allocate(mLength + length);
     MCAssert(mUnicodeChars != NULL);
     memcpy(&mUnicodeChars[mLength], unicodeCharacters, length * sizeof(* mUnicodeChars));
@@ -1020,6 +1027,25 @@ void String::appendUTF8CharactersLength(const char * UTF8Characters, unsigned in
         return;
     }
 
+    // Most header values and identifiers are plain ASCII: widen them in place
+    // instead of going through a temporary UTF-16 buffer.
+    const unsigned char * bytes = (const unsigned char *) UTF8Characters;
+    unsigned char highBits = 0;
+    for(unsigned int i = 0 ; i < length ; i ++) {
+        highBits |= bytes[i];
+    }
+    if (highBits < 0x80) {
+        invalidateUTF8Cache();
+        allocate(mLength + length);
+        UChar * dest = &mUnicodeChars[mLength];
+        for(unsigned int i = 0 ; i < length ; i ++) {
+            dest[i] = bytes[i];
+        }
+        mLength += length;
+        mUnicodeChars[mLength] = 0;
+        return;
+    }
+
     const UTF8 * source = (const UTF8 *) UTF8Characters;
     UTF16 * target = (UTF16 *) malloc(length * sizeof(* target));
     UTF16 * targetStart = target;
@@ -1049,18 +1075,67 @@ const UChar * String::unicodeCharacters()
     return mUnicodeChars;
 }
 
-const char * String::UTF8Characters()
+static void utf8CacheDeallocator(char * bytes, unsigned int length)
+{
+    free(bytes);
+}
+
+Data * String::createUTF8Data()
 {
-    const UTF16 * source = (const UTF16 *) mUnicodeChars;
-    UTF8 * target = (UTF8 *) malloc(mLength * 6 + 1);
-    UTF8 * targetStart = target;
-    ConvertUTF16toUTF8(&source, source + mLength,
-                       &targetStart, targetStart + mLength * 6 + 1, lenientConversion);
-    unsigned int utf8length = (unsigned int) (targetStart - target);
+    // Pure ASCII strings map one code unit to one byte. Check that with a
+    // branch-free reduction so that both loops can be vectorized.
+    UChar highBits = 0;
+    for(unsigned int i = 0 ; i < mLength ; i ++) {
+        highBits |= mUnicodeChars[i];
+    }
+
+    char * target;
+    unsigned int utf8length;
+    if (highBits < 0x80) {
+        target = (char *) malloc(mLength + 1);
+        for(unsigned int i = 0 ; i < mLength ; i ++) {
+            target[i] = (char) mUnicodeChars[i];
+        }
+        utf8length = mLength;
+    }
+    else {
+        // A UTF-16 code unit never needs more than 3 bytes of UTF-8.
+        const UTF16 * source = (const UTF16 *) mUnicodeChars;
+        UTF8 * utf8Target = (UTF8 *) malloc(mLength * 3 + 1);
+        UTF8 * targetStart = utf8Target;
+        ConvertUTF16toUTF8(&source, source + mLength,
+                           &targetStart, targetStart + mLength * 3 + 1, lenientConversion);
+        utf8length = (unsigned int) (targetStart - utf8Target);
+        target = (char *) realloc(utf8Target, utf8length + 1);
+    }
     target[utf8length] = 0;
-    Data * data = Data::dataWithBytes((const char *) target, utf8length + 1);
-    free(target);
-    
+
+    Data * data = new Data();
+    data->takeBytesOwnership(target, utf8length + 1, utf8CacheDeallocator);
+    return data;
+}
+
+void String::invalidateUTF8Cache()
+{
+    Data * cache = mUTF8Cache.exchange(NULL);
+    MC_SAFE_RELEASE(cache);
+}
+
+const char * String::UTF8Characters()
+{
+    Data * data = mUTF8Cache.load(std::memory_order_acquire);
+    if (data == NULL) {
+        data = createUTF8Data();
+        // Shared strings (MCSTR()) may be converted from several threads at once.
+        Data * expected = NULL;
+        if (!mUTF8Cache.compare_exchange_strong(expected, data)) {
+            data->release();
+            data = expected;
+        }
+    }
+    // Callers may keep the pointer until the pool drains, even if this string
+    // is mutated or released in the meantime.
+    data->retain()->autorelease();
     return data->bytes();
 }
 
@@ -1101,6 +1176,7 @@ String * String::stringByAppendingCharacters(const UChar * unicodeCharacters)
 
 void String::reset()
 {
+    invalidateUTF8Cache();
     free(mUnicodeChars);
     mUnicodeChars = NULL;
     mLength = 0;
@@ -1338,12 +1414,177 @@ String * String::uppercaseString()
 #endif
 }
 
+// Charsets that map every 7-bit byte to the same code point.
+static bool isASCIICompatibleCharset(const char * charset)
+{
+    static const char * prefixes[] = {
+        "us-ascii", "ascii", "utf-8", "utf8", "iso-8859-", "iso8859-", "windows-125", "cp125", "koi8-",
+    };
+    for(unsigned int i = 0 ; i < sizeof(prefixes) / sizeof(prefixes[0]) ; i ++) {
+        if (strncasecmp(charset, prefixes[i], strlen(prefixes[i])) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool isUTF8Charset(const char * charset)
+{
+    return (strcasecmp(charset, "utf-8") == 0) || (strcasecmp(charset, "utf8") == 0);
+}
+
+// Strict UTF-8 validation (no overlong forms, surrogates or values above
+// U+10FFFF). NUL is rejected too since converted NULs are turned into spaces.
+static bool isValidUTF8WithoutNUL(const unsigned char * bytes, unsigned int length, bool * pIsASCII)
+{
+    bool isASCII = true;
+    unsigned int i = 0;
+    while (i < length) {
+        unsigned char c = bytes[i];
+        if (c == 0) {
+            return false;
+        }
+        if (c < 0x80) {
+            i ++;
+            continue;
+        }
+        isASCII = false;
+        unsigned int count;
+        unsigned char min = 0x80;
+        unsigned char max = 0xBF;
+        if ((c >= 0xC2) && (c <= 0xDF)) {
+            count = 1;
+        }
+        else if ((c >= 0xE0) && (c <= 0xEF)) {
+            count = 2;
+            if (c == 0xE0) {
+                min = 0xA0;
+            }
+            else if (c == 0xED) {
+                max = 0x9F;
+            }
+        }
+        else if ((c >= 0xF0) && (c <= 0xF4)) {
+            count = 3;
+            if (c == 0xF0) {
+                min = 0x90;
+            }
+            else if (c == 0xF4) {
+                max = 0x8F;
+            }
+        }
+        else {
+            return false;
+        }
+        if (length - i - 1 < count) {
+            return false;
+        }
+        if ((bytes[i + 1] < min) || (bytes[i + 1] > max)) {
+            return false;
+        }
+        for(unsigned int k = 2 ; k <= count ; k ++) {
+            if ((bytes[i + k] & 0xC0) != 0x80) {
+                return false;
+            }
+        }
+        i += count + 1;
+    }
+    * pIsASCII = isASCII;
+    return true;
+}
+
+#if !DISABLE_ICU
+#define CONVERTER_CACHE_SIZE 8
+
+struct converter_cache_entry {
+    char name[64];
+    UConverter * converter;
+};
+
+struct converter_cache {
+    struct converter_cache_entry entries[CONVERTER_CACHE_SIZE];
+    unsigned int next;
+};
+
+static pthread_key_t converterCacheKey;
+
+static void destroyConverterCache(void * value)
+{
+    struct converter_cache * cache = (struct converter_cache *) value;
+    for(unsigned int i = 0 ; i < CONVERTER_CACHE_SIZE ; i ++) {
+        if (cache->entries[i].converter != NULL) {
+            ucnv_close(cache->entries[i].converter);
+        }
+    }
+    free(cache);
+}
+
+static void initConverterCacheKey()
+{
+    pthread_key_create(&converterCacheKey, destroyConverterCache);
+}
+
+// Opening a converter loads and parses its mapping tables, so each thread keeps
+// the few it has used recently. The result is owned by the cache unless
+// pOwned is set, in which case the caller closes it.
+static UConverter * cachedConverter(const char * charset, bool * pOwned)
+{
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    UErrorCode err = U_ZERO_ERROR;
+
+    * pOwned = false;
+    pthread_once(&once, initConverterCacheKey);
+    struct converter_cache * cache = (struct converter_cache *) pthread_getspecific(converterCacheKey);
+    if (cache == NULL) {
+        cache = (struct converter_cache *) calloc(1, sizeof(* cache));
+        pthread_setspecific(converterCacheKey, cache);
+    }
+
+    for(unsigned int i = 0 ; i < CONVERTER_CACHE_SIZE ; i ++) {
+        struct converter_cache_entry * entry = &cache->entries[i];
+        if ((entry->converter != NULL) && (strcasecmp(entry->name, charset) == 0)) {
+            ucnv_reset(entry->converter);
+            return entry->converter;
+        }
+    }
+
+    UConverter * converter = ucnv_open(charset, &err);
+    if (converter == NULL) {
+        MCLog("invalid charset %s %i", charset, err);
+        return NULL;
+    }
+    if (strlen(charset) >= sizeof(cache->entries[0].name)) {
+        * pOwned = true;
+        return converter;
+    }
+
+    struct converter_cache_entry * entry = &cache->entries[cache->next];
+    cache->next = (cache->next + 1) % CONVERTER_CACHE_SIZE;
+    if (entry->converter != NULL) {
+        ucnv_close(entry->converter);
+    }
+    strcpy(entry->name, charset);
+    entry->converter = converter;
+    return converter;
+}
+#endif
+
 void String::appendBytes(const char * bytes, unsigned int length, const char * charset)
 {
     if (bytes == NULL) {
         return;
     }
 
+    // Most parts are ASCII or well-formed UTF-8 and don't need a converter.
+    if (isASCIICompatibleCharset(charset)) {
+        bool isASCII;
+        if (isValidUTF8WithoutNUL((const unsigned char *) bytes, length, &isASCII) &&
+            (isASCII || isUTF8Charset(charset))) {
+            appendUTF8CharactersLength(bytes, length);
+            return;
+        }
+    }
+
 #if __APPLE__
     CFStringEncoding encoding;
     if (strcasecmp(charset, "mutf-7") == 0) {
@@ -1407,21 +1648,30 @@ void String::appendBytes(const char * bytes, unsigned int length, const char * c
         charset = "IMAP-mailbox-name";
     }
 
-    err = U_ZERO_ERROR;
-    UConverter * converter = ucnv_open(charset, &err); 
+    bool ownsConverter;
+    UConverter * converter = cachedConverter(charset, &ownsConverter);
     if (converter == NULL) {
-        MCLog("invalid charset %s %i", charset, err);
         return;
     }
     
+    // Decoding rarely yields more UTF-16 units than input bytes: convert straight
+    // into our buffer and only measure first if that guess is too small.
+    invalidateUTF8Cache();
+    int32_t destCapacity = length + 1;
+    allocate(mLength + destCapacity);
     err = U_ZERO_ERROR;
-    int32_t destLength = ucnv_toUChars(converter, NULL, 0,
-        bytes, length, &err);
-    int32_t destCapacity = destLength + 1;
-    UChar * dest = (UChar *) malloc(destCapacity * sizeof(* dest));
-    err = U_ZERO_ERROR;
-    destLength = ucnv_toUChars(converter, dest, destCapacity, bytes, length, &err);
-    dest[destLength] = 0;
+    int32_t destLength = ucnv_toUChars(converter, &mUnicodeChars[mLength], destCapacity, bytes, length, &err);
+    if (err == U_BUFFER_OVERFLOW_ERROR) {
+        destCapacity = destLength + 1;
+        allocate(mLength + destCapacity);
+        ucnv_reset(converter);
+        err = U_ZERO_ERROR;
+        destLength = ucnv_toUChars(converter, &mUnicodeChars[mLength], destCapacity, bytes, length, &err);
+    }
+    if (U_FAILURE(err)) {
+        destLength = 0;
+    }
+    UChar * dest = &mUnicodeChars[mLength];
     
     // Fix in case of bad conversion.
     for(int32_t i = 0 ; i < destLength ; i ++) {
@@ -1430,10 +1680,12 @@ void String::appendBytes(const char * bytes, unsigned int length, const char * c
         }
     }
     
-    appendCharactersLength(dest, destLength);
-    free(dest);
+    mLength += destLength;
+    mUnicodeChars[mLength] = 0;
     
-    ucnv_close(converter);
+    if (ownsConverter) {
+        ucnv_close(converter);
+    }
 #endif
 }
 
@@ -1540,6 +1792,7 @@ unsigned int String::replaceOccurrencesOfString(String * occurrence, String * re
         * dest_p = 0;
     }
     
+    invalidateUTF8Cache();
     free(mUnicodeChars);
     mUnicodeChars = unicodeChars;
     mLength = modifiedLength - 1;
@@ -1564,6 +1817,7 @@ void String::deleteCharactersInRange(Range range)
         range.length = mLength - range.location;
     }
     
+    invalidateUTF8Cache();
     int32_t count = mLength - (int32_t) (range.location + range.length);
     memmove(&mUnicodeChars[range.location], &mUnicodeChars[range.location + range.length], count * sizeof(* mUnicodeChars));
     mLength -= range.length;
@@ -1609,8 +1863,13 @@ struct parserState {
     bool hasReturnToLine;
     Array * linkStack;
     Array * paragraphSpacingStack;
+    htmlParserCtxtPtr ctxt;
+    unsigned int maxLength;
+    unsigned int nextLengthCheck;
 };
 
+static void stopParsingIfFull(struct parserState * state);
+
 static void appendQuote(struct parserState * state);
 
 static inline int isWhitespace(UChar ch)
@@ -1714,10 +1973,25 @@ static void charactersParsed(void * context,
             result->appendString(modifiedString);
             state->lastCharIsWhitespace = lastIsWhiteSpace;
             state->hasText = true;
+            stopParsingIfFull(state);
         }
     }
 }
 
+static void stopParsingIfFull(struct parserState * state)
+{
+    if ((state->maxLength == 0) || (state->result->length() < state->nextLengthCheck)) {
+        return;
+    }
+    // Quote prefixes and line breaks collapse in stripWhitespace(), so measure
+    // what will remain. Checks are spaced geometrically to keep this linear.
+    if (state->result->stripWhitespace()->length() >= state->maxLength) {
+        xmlStopParser(state->ctxt);
+        return;
+    }
+    state->nextLengthCheck = state->result->length() * 2;
+}
+
 /* GCS: custom error function to ignore errors */
 /* Note: libxml2 2.12+ changed xmlErrorPtr to const xmlError * */
 #if LIBXML_VERSION >= 21200
@@ -2094,6 +2368,36 @@ void initializeLibXML()
     MC_UNLOCK(&lock);
 }
 
+static void initParserState(struct parserState * state, String * result, bool showBlockquote, bool showLink)
+{
+    state->result = result;
+    state->level = 0;
+    state->enabled = 1;
+    state->logEnabled = 0;
+    state->disabledLevel = 0;
+    state->quoteLevel = 0;
+    state->hasText = false;
+    state->hasQuote = false;
+    state->hasReturnToLine = false;
+    state->showBlockQuote = showBlockquote;
+    state->showLink = showLink;
+    state->lastCharIsWhitespace = true;
+    state->linkStack = new Array();
+    state->paragraphSpacingStack = new Array();
+    state->ctxt = NULL;
+    state->maxLength = 0;
+    state->nextLengthCheck = 0;
+}
+
+static void initFlattenSAXHandler(xmlSAXHandler * handler)
+{
+    memset(handler, 0, sizeof(xmlSAXHandler));
+    handler->characters = charactersParsed;
+    handler->startElement = elementStarted;
+    handler->endElement = elementEnded;
+    handler->comment = commentParsed;
+}
+
 String * String::flattenHTMLAndShowBlockquoteAndLink(bool showBlockquote, bool showLink)
 /*" Interpretes the receiver als HTML, removes all tags
  and returns the plain text. "*/
@@ -2103,26 +2407,9 @@ String * String::flattenHTMLAndShowBlockquoteAndLink(bool showBlockquote, bool s
     int mem_base = xmlMemBlocks();
     String * result = String::string();
     xmlSAXHandler handler;
-    memset(&handler, 0, sizeof(xmlSAXHandler));
-    handler.characters = charactersParsed;
-    handler.startElement = elementStarted;
-    handler.endElement = elementEnded;
-    handler.comment = commentParsed;
+    initFlattenSAXHandler(&handler);
     struct parserState state;
-    state.result = result;
-    state.level = 0;
-    state.enabled = 1;
-    state.logEnabled = 0;
-    state.disabledLevel = 0;
-    state.quoteLevel = 0;
-    state.hasText = false;
-    state.hasQuote = false;
-    state.hasReturnToLine = false;
-    state.showBlockQuote = showBlockquote;
-    state.showLink = showLink;
-    state.lastCharIsWhitespace = true;
-    state.linkStack = new Array();
-    state.paragraphSpacingStack = new Array();
+    initParserState(&state, result, showBlockquote, showLink);
 
     String * cleanedHTML = cleanedHTMLString();
     if (cleanedHTML == NULL) {
@@ -2154,6 +2441,37 @@ String * String::flattenHTMLAndShowBlockquoteAndLink(bool showBlockquote, bool s
     return result;
 }
 
+String * String::flattenHTMLWithMaxLength(unsigned int maxLength)
+{
+    initializeLibXML();
+    
+    String * result = String::string();
+    xmlSAXHandler handler;
+    initFlattenSAXHandler(&handler);
+    struct parserState state;
+    initParserState(&state, result, true, true);
+    state.maxLength = maxLength;
+    state.nextLengthCheck = maxLength;
+    
+    // The push parser exposes its context, which lets the SAX callbacks stop
+    // the parse as soon as enough text has been collected.
+    const char * characters = UTF8Characters();
+    htmlParserCtxtPtr ctxt = htmlCreatePushParserCtxt(&handler, &state, NULL, 0, NULL, XML_CHAR_ENCODING_UTF8);
+    if (ctxt != NULL) {
+        // The string is already decoded to UTF-8: ignore any legacy <meta charset> in the document.
+        htmlCtxtUseOptions(ctxt, ctxt->options | HTML_PARSE_IGNORE_ENC);
+        state.ctxt = ctxt;
+        htmlParseChunk(ctxt, characters, (int) strlen(characters), 1);
+        htmlFreeParserCtxt(ctxt);
+    }
+    
+    cleanTerminalSpace(state.result);
+    state.paragraphSpacingStack->release();
+    state.linkStack->release();
+    
+    return result;
+}
+
 String * String::flattenHTMLAndShowBlockquote(bool showBlockquote)
 {
     return flattenHTMLAndShowBlockquoteAndLink(showBlockquote, true);
@@ -2317,19 +2635,30 @@ Data * String::dataUsingEncoding(const char * charset)
         charset = "IMAP-mailbox-name";
     }
 
-    err = U_ZERO_ERROR;
-    UConverter * converter = ucnv_open(charset, &err); 
+    bool ownsConverter;
+    UConverter * converter = cachedConverter(charset, &ownsConverter);
     if (converter == NULL) {
-        MCLog("invalid charset %s %i", charset, err);
         return NULL;
     }
 
-    err = U_ZERO_ERROR;
-    int32_t destLength = ucnv_fromUChars(converter, NULL, 0, mUnicodeChars, mLength, &err);
-    int32_t destCapacity = destLength + 1;
+    // UCNV_GET_MAX_BYTES_FOR_STRING also accounts for the bytes stateful encodings
+    // (ISO-2022-JP, UTF-7) write when they flush, so a single pass normally fits.
+    // Measure and retry if it doesn't.
+    int32_t destCapacity = UCNV_GET_MAX_BYTES_FOR_STRING(mLength, ucnv_getMaxCharSize(converter)) + 1;
     char * dest = (char *) malloc(destCapacity * sizeof(* dest));
     err = U_ZERO_ERROR;
-    destLength = ucnv_fromUChars(converter, dest, destCapacity, mUnicodeChars, mLength, &err);
+    int32_t destLength = ucnv_fromUChars(converter, dest, destCapacity, mUnicodeChars, mLength, &err);
+    if (err == U_BUFFER_OVERFLOW_ERROR) {
+        free(dest);
+        destCapacity = destLength + 1;
+        dest = (char *) malloc(destCapacity * sizeof(* dest));
+        ucnv_reset(converter);
+        err = U_ZERO_ERROR;
+        destLength = ucnv_fromUChars(converter, dest, destCapacity, mUnicodeChars, mLength, &err);
+    }
+    if (U_FAILURE(err) || destLength >= destCapacity) {
+        destLength = 0;
+    }
     dest[destLength] = 0;
     
     // Fix in case of bad conversion.
@@ -2343,7 +2672,9 @@ Data * String::dataUsingEncoding(const char * charset)
     
     free(dest);
     
-    ucnv_close(converter);
+    if (ownsConverter) {
+        ucnv_close(converter);
+    }
     
     return data;
 #endif
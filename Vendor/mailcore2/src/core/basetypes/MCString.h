@@ -11,6 +11,8 @@
 
 #ifdef __cplusplus
 
+#include <atomic>
+
 namespace mailcore {
     
     class Data;
@@ -88,6 +90,9 @@ namespace mailcore {
         virtual String * flattenHTML();
         virtual String * flattenHTMLAndShowBlockquote(bool showBlockquote);
         virtual String * flattenHTMLAndShowBlockquoteAndLink(bool showBlockquote, bool showLink);
+        // Single libxml2 pass without HTMLCleaner. Parsing stops once the text,
+        // after stripWhitespace(), would be at least maxLength characters long.
+        virtual String * flattenHTMLWithMaxLength(unsigned int maxLength);
         
         virtual String * stripWhitespace();
         
@@ -136,8 +141,12 @@ namespace mailcore {
         UChar * mUnicodeChars;
         unsigned int mLength;
         unsigned int mAllocated;
+        // UTF-8 representation returned by UTF8Characters(), dropped on mutation.
+        std::atomic<Data *> mUTF8Cache;
         void allocate(unsigned int length, bool force = false);
         void reset();
+        void invalidateUTF8Cache();
+        Data * createUTF8Data();
         int compareWithCaseSensitive(String * otherString, bool caseSensitive);
         void appendBytes(const char * bytes, unsigned int length, const char * charset);
         void appendUTF8CharactersLength(const char * UTF8Characters, unsigned int length);
@@ -9,6 +9,7 @@
 namespace mailcore {
     
     class IMAPSession;
+    class IMAPMessage;
     
     class MAILCORE_EXPORT IMAPProgressCallback {
     public:
@@ -16,6 +17,14 @@ namespace mailcore {
         virtual void itemsProgress(IMAPSession * session, unsigned int current, unsigned int maximum) {};
     };
     
+    // Receives each message of a streaming fetch as soon as it is parsed.
+    // The message is released when the call returns unless it is retained.
+    // Must not throw: it is called from within the libetpan parser.
+    class MAILCORE_EXPORT IMAPMessagesStreamCallback {
+    public:
+        virtual void fetchedMessage(IMAPSession * session, IMAPMessage * message) {};
+    };
+    
 }
 
 #endif
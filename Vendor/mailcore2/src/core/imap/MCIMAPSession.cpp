@@ -652,6 +652,11 @@ void IMAPSession::setup()
     mailimap_set_timeout(mImap, timeout());
     mailimap_set_progress_callback(mImap, body_progress, IMAPSession::items_progress, this);
     mailimap_set_logger(mImap, logger, this);
+#ifdef LIBETPAN_HAS_MAILIMAP_ARENA
+    // Messages handed to msg_att_handler are built in an arena and released
+    // in one step instead of one free() per list cell and attribute.
+    mailimap_set_arena_enabled(mImap, 1);
+#endif
 }
 
 void IMAPSession::unsetup()
@@ -1256,6 +1261,104 @@ void IMAPSession::select(String * folder, ErrorCode * pError)
 
 
 
+static struct mailimap_status_att_list * createStatusAttList(bool highestModSeq)
+{
+    struct mailimap_status_att_list * status_att_list;
+    
+    status_att_list = mailimap_status_att_list_new_empty();
+    mailimap_status_att_list_add(status_att_list, MAILIMAP_STATUS_ATT_UNSEEN);
+    mailimap_status_att_list_add(status_att_list, MAILIMAP_STATUS_ATT_MESSAGES);
+    mailimap_status_att_list_add(status_att_list, MAILIMAP_STATUS_ATT_RECENT);
+    mailimap_status_att_list_add(status_att_list, MAILIMAP_STATUS_ATT_UIDNEXT);
+    mailimap_status_att_list_add(status_att_list, MAILIMAP_STATUS_ATT_UIDVALIDITY);
+    if (highestModSeq) {
+        mailimap_status_att_list_add(status_att_list, MAILIMAP_STATUS_ATT_HIGHESTMODSEQ);
+    }
+    return status_att_list;
+}
+
+static void applyStatusData(IMAPFolderStatus * fs, struct mailimap_mailbox_data_status * status)
+{
+    clistiter * cur;
+    
+    struct mailimap_status_info * status_info;
+    for(cur = clist_begin(status->st_info_list) ; cur != NULL ;
+        cur = clist_next(cur)) {
+        
+        status_info = (struct mailimap_status_info *) clist_content(cur);
+        
+        switch (status_info->st_att) {
+            case MAILIMAP_STATUS_ATT_UNSEEN:
+                fs->setUnseenCount(status_info->st_value);
+                break;
+            case MAILIMAP_STATUS_ATT_MESSAGES:
+                fs->setMessageCount(status_info->st_value);
+                break;
+            case MAILIMAP_STATUS_ATT_RECENT:
+                fs->setRecentCount(status_info->st_value);
+                break;
+            case MAILIMAP_STATUS_ATT_UIDNEXT:
+                fs->setUidNext(status_info->st_value);
+                break;
+            case MAILIMAP_STATUS_ATT_UIDVALIDITY:
+                fs->setUidValidity(status_info->st_value);
+                break;
+            case MAILIMAP_STATUS_ATT_EXTENSION: {
+                struct mailimap_extension_data * ext_data = status_info->st_ext_data;
+                if (ext_data->ext_extension == &mailimap_extension_condstore) {
+                    struct mailimap_condstore_status_info * status_info = (struct mailimap_condstore_status_info *) ext_data->ext_data;
+                    fs->setHighestModSeqValue(status_info->cs_highestmodseq_value);
+                }
+                break;
+            }
+        }
+    }
+}
+
+// The mailbox name of an untagged STATUS response is the raw token sent by the server,
+// it may still be quoted. INBOX is case-insensitive.
+static String * statusMailboxKey(String * name)
+{
+    if (name->caseInsensitiveCompare(MCSTR("INBOX")) == 0) {
+        return MCSTR("INBOX");
+    }
+    return name;
+}
+
+static String * statusMailboxKey(const char * rawName)
+{
+    size_t len = strlen(rawName);
+    if ((len >= 2) && (rawName[0] == '"') && (rawName[len - 1] == '"')) {
+        char * unquoted = (char *) malloc(len);
+        size_t unquotedLen = 0;
+        for(size_t i = 1 ; i < len - 1 ; i ++) {
+            if ((rawName[i] == '\\') && (i + 1 < len - 1)) {
+                i ++;
+            }
+            unquoted[unquotedLen ++] = rawName[i];
+        }
+        unquoted[unquotedLen] = 0;
+        String * name = String::stringWithUTF8Characters(unquoted);
+        free(unquoted);
+        return statusMailboxKey(name);
+    }
+    return statusMailboxKey(String::stringWithUTF8Characters(rawName));
+}
+
+static void addStatusResponses(HashMap * statuses, clist * status_list)
+{
+    for(clistiter * cur = clist_begin(status_list) ; cur != NULL ; cur = clist_next(cur)) {
+        struct mailimap_mailbox_data_status * status = (struct mailimap_mailbox_data_status *) clist_content(cur);
+        if (status->st_mailbox == NULL) {
+            continue;
+        }
+        IMAPFolderStatus * fs = new IMAPFolderStatus();
+        applyStatusData(fs, status);
+        statuses->setObjectForKey(statusMailboxKey(status->st_mailbox), fs);
+        fs->release();
+    }
+}
+
 IMAPFolderStatus * IMAPSession::folderStatus(String * folder, ErrorCode * pError)
 {
     int r;
@@ -1267,15 +1370,7 @@ IMAPFolderStatus * IMAPSession::folderStatus(String * folder, ErrorCode * pError
 
     struct mailimap_status_att_list * status_att_list;
         
-    status_att_list = mailimap_status_att_list_new_empty();
-    mailimap_status_att_list_add(status_att_list, MAILIMAP_STATUS_ATT_UNSEEN);
-    mailimap_status_att_list_add(status_att_list, MAILIMAP_STATUS_ATT_MESSAGES);
-    mailimap_status_att_list_add(status_att_list, MAILIMAP_STATUS_ATT_RECENT);
-    mailimap_status_att_list_add(status_att_list, MAILIMAP_STATUS_ATT_UIDNEXT);
-    mailimap_status_att_list_add(status_att_list, MAILIMAP_STATUS_ATT_UIDVALIDITY);
-    if (mCondstoreEnabled || mXYMHighestModseqEnabled) {
-        mailimap_status_att_list_add(status_att_list, MAILIMAP_STATUS_ATT_HIGHESTMODSEQ);
-    }
+    status_att_list = createStatusAttList(mCondstoreEnabled || mXYMHighestModseqEnabled);
     
     r = mailimap_status(mImap, MCUTF8(folder), status_att_list, &status);
     
@@ -1303,44 +1398,8 @@ IMAPFolderStatus * IMAPSession::folderStatus(String * folder, ErrorCode * pError
         return fs;
     }
     
-    clistiter * cur;
-    
-    
     if (status != NULL) {
-        
-            struct mailimap_status_info * status_info;
-            for(cur = clist_begin(status->st_info_list) ; cur != NULL ;
-                cur = clist_next(cur)) {                
-                
-                status_info = (struct mailimap_status_info *) clist_content(cur);
-                                
-                switch (status_info->st_att) {
-                    case MAILIMAP_STATUS_ATT_UNSEEN:
-                        fs->setUnseenCount(status_info->st_value);
-                        break;
-                    case MAILIMAP_STATUS_ATT_MESSAGES:
-                        fs->setMessageCount(status_info->st_value);
-                        break;
-                    case MAILIMAP_STATUS_ATT_RECENT:
-                        fs->setRecentCount(status_info->st_value);
-                        break;
-                    case MAILIMAP_STATUS_ATT_UIDNEXT:
-                        fs->setUidNext(status_info->st_value);
-                        break;                        
-                    case MAILIMAP_STATUS_ATT_UIDVALIDITY:
-                        fs->setUidValidity(status_info->st_value);
-                        break;
-                    case MAILIMAP_STATUS_ATT_EXTENSION: {
-                        struct mailimap_extension_data * ext_data = status_info->st_ext_data;
-                        if (ext_data->ext_extension == &mailimap_extension_condstore) {
-                            struct mailimap_condstore_status_info * status_info = (struct mailimap_condstore_status_info *) ext_data->ext_data;
-                            fs->setHighestModSeqValue(status_info->cs_highestmodseq_value);
-                        }
-                        break;
-                    }
-                }
-            }            
-
+        applyStatusData(fs, status);
         mailimap_mailbox_data_status_free(status);
     }
 
@@ -1349,6 +1408,85 @@ IMAPFolderStatus * IMAPSession::folderStatus(String * folder, ErrorCode * pError
     return fs;
 }
 
+HashMap * IMAPSession::folderStatuses(Array * folders, ErrorCode * pError)
+{
+    int r;
+    
+    MCLog("status of %u folders", folders->count());
+    MCAssert(mState == STATE_LOGGEDIN || mState == STATE_SELECTED);
+    
+    struct mailimap_status_att_list * status_att_list;
+    clist * status_list;
+    HashMap * statuses = HashMap::hashMap();
+    
+    status_att_list = createStatusAttList(mCondstoreEnabled || mXYMHighestModseqEnabled);
+    
+    // One round trip for every folder of the account.
+    if (mailimap_has_list_status(mImap)) {
+        r = mailimap_list_status(mImap, "", "*", status_att_list, &status_list);
+        if (r == MAILIMAP_ERROR_STREAM) {
+            mShouldDisconnect = true;
+            * pError = ErrorConnection;
+            mailimap_status_att_list_free(status_att_list);
+            return NULL;
+        }
+        else if (r == MAILIMAP_ERROR_PARSE) {
+            mShouldDisconnect = true;
+            * pError = ErrorParse;
+            mailimap_status_att_list_free(status_att_list);
+            return NULL;
+        }
+        else if (hasError(r)) {
+            MCLog("list-status error : %i, falling back to status", r);
+        }
+        else {
+            addStatusResponses(statuses, status_list);
+            mailimap_list_status_free(status_list);
+        }
+    }
+    
+    // Pipelined STATUS for the folders that LIST-STATUS did not cover.
+    clist * missing = clist_new();
+    mc_foreacharray(String, folder, folders) {
+        if (statuses->objectForKey(statusMailboxKey(folder)) == NULL) {
+            clist_append(missing, (void *) MCUTF8(folder));
+        }
+    }
+    if (!clist_isempty(missing)) {
+        r = mailimap_status_pipelined(mImap, missing, status_att_list, &status_list);
+        if (r == MAILIMAP_ERROR_PARSE) {
+            mShouldDisconnect = true;
+            * pError = ErrorParse;
+            clist_free(missing);
+            mailimap_status_att_list_free(status_att_list);
+            return NULL;
+        }
+        else if (hasError(r)) {
+            // The tags of the remaining responses can't be trusted anymore.
+            mShouldDisconnect = true;
+            * pError = ErrorConnection;
+            clist_free(missing);
+            mailimap_status_att_list_free(status_att_list);
+            return NULL;
+        }
+        addStatusResponses(statuses, status_list);
+        mailimap_list_status_free(status_list);
+    }
+    clist_free(missing);
+    mailimap_status_att_list_free(status_att_list);
+    
+    HashMap * result = HashMap::hashMap();
+    mc_foreacharray(String, requestedFolder, folders) {
+        IMAPFolderStatus * fs = (IMAPFolderStatus *) statuses->objectForKey(statusMailboxKey(requestedFolder));
+        if (fs != NULL) {
+            result->setObjectForKey(requestedFolder, fs);
+        }
+    }
+    
+    * pError = ErrorNone;
+    return result;
+}
+
 void IMAPSession::noop(ErrorCode * pError)
 {
     int r;
@@ -2274,9 +2412,27 @@ struct msg_att_handler_data {
     bool needsGmailLabels;
     bool needsGmailMessageID;
     bool needsGmailThreadID;
+    IMAPSession * session;
+    IMAPMessagesStreamCallback * streamCallback;
+    unsigned int streamedCount;
 };
 
+static void msg_att_handler_impl(struct mailimap_msg_att * msg_att, void * context);
+
 static void msg_att_handler(struct mailimap_msg_att * msg_att, void * context)
+{
+    struct msg_att_handler_data * msg_att_context = (struct msg_att_handler_data *) context;
+    if (msg_att_context->streamCallback == NULL) {
+        msg_att_handler_impl(msg_att, context);
+        return;
+    }
+    // When streaming, drain everything the message allocated before the next one is parsed.
+    AutoreleasePool * pool = new AutoreleasePool();
+    msg_att_handler_impl(msg_att, context);
+    pool->release();
+}
+
+static void msg_att_handler_impl(struct mailimap_msg_att * msg_att, void * context)
 {
     clistiter * item_iter;
     uint32_t uid;
@@ -2503,7 +2659,13 @@ static void msg_att_handler(struct mailimap_msg_att * msg_att, void * context)
         }
     }
     
-    result->addObject(msg);
+    if (msg_att_context->streamCallback != NULL) {
+        msg_att_context->streamCallback->fetchedMessage(msg_att_context->session, msg);
+        msg_att_context->streamedCount ++;
+    }
+    else {
+        result->addObject(msg);
+    }
     msg->release();
     
     msg_att_context->mLastFetchedSequenceNumber = mLastFetchedSequenceNumber;
@@ -2512,7 +2674,8 @@ static void msg_att_handler(struct mailimap_msg_att * msg_att, void * context)
 IMAPSyncResult * IMAPSession::fetchMessages(String * folder, IMAPMessagesRequestKind requestKind, bool fetchByUID,
                                             struct mailimap_set * imapset, IndexSet * uidsFilter, IndexSet * numbersFilter,
                                             uint64_t modseq, HashMap * mapping,
-                                            IMAPProgressCallback * progressCallback, Array * extraHeaders, ErrorCode * pError)
+                                            IMAPProgressCallback * progressCallback, Array * extraHeaders,
+                                            IMAPMessagesStreamCallback * streamCallback, ErrorCode * pError)
 {
     struct mailimap_fetch_type * fetch_type;
     clist * fetch_result;
@@ -2695,6 +2858,8 @@ IMAPSyncResult * IMAPSession::fetchMessages(String * folder, IMAPMessagesRequest
     msg_att_data.needsGmailLabels = needsGmailLabels;
     msg_att_data.needsGmailMessageID = needsGmailMessageID;
     msg_att_data.needsGmailThreadID = needsGmailThreadID;
+    msg_att_data.session = this;
+    msg_att_data.streamCallback = streamCallback;
     mailimap_set_msg_att_handler(mImap, msg_att_handler, &msg_att_data);
     
     mBodyProgressEnabled = false;
@@ -2745,6 +2910,13 @@ IMAPSyncResult * IMAPSession::fetchMessages(String * folder, IMAPMessagesRequest
     
     mailimap_set_msg_att_handler(mImap, NULL, NULL);
     
+#ifdef LIBETPAN_HAS_MAILIMAP_ARENA
+    struct carena_stats arenaStats;
+    mailimap_get_arena_stats(mImap, &arenaStats);
+    MCLog("fetch arena: %lu allocations from %lu chunks, %lu messages released",
+          arenaStats.arena_allocations, arenaStats.chunk_allocations, arenaStats.resets);
+#endif
+    
     if (r == MAILIMAP_ERROR_STREAM) {
         MCLog("error stream");
         mShouldDisconnect = true;
@@ -2770,7 +2942,7 @@ IMAPSyncResult * IMAPSession::fetchMessages(String * folder, IMAPMessagesRequest
     result->autorelease();
     
     if ((requestKind & IMAPMessagesRequestKindHeaders) != 0) {
-        if (messages->count() == 0) {
+        if ((messages->count() == 0) && (msg_att_data.streamedCount == 0)) {
             unsigned int count;
             
             count = clist_count(fetch_result);
@@ -2780,7 +2952,7 @@ IMAPSyncResult * IMAPSession::fetchMessages(String * folder, IMAPMessagesRequest
 
                 result = fetchMessages(folder, requestKind, fetchByUID,
                     imapset, uidsFilter, numbersFilter,
-                    modseq, NULL, progressCallback, extraHeaders, pError);
+                    modseq, NULL, progressCallback, extraHeaders, streamCallback, pError);
                 if (result != NULL) {
                     if (result->modifiedOrAddedMessages() != NULL) {
                         if (result->modifiedOrAddedMessages()->count() > 0) {
@@ -2811,7 +2983,7 @@ Array * IMAPSession::fetchMessagesByUIDWithExtraHeaders(String * folder, IMAPMes
 {
     struct mailimap_set * imapset = setFromIndexSet(uids);
     IMAPSyncResult * syncResult = fetchMessages(folder, requestKind, true, imapset, uids, NULL, 0, NULL,
-                                                progressCallback, extraHeaders, pError);
+                                                progressCallback, extraHeaders, NULL, pError);
     if (syncResult == NULL) {
         mailimap_set_free(imapset);
         return NULL;
@@ -2822,6 +2994,16 @@ Array * IMAPSession::fetchMessagesByUIDWithExtraHeaders(String * folder, IMAPMes
     return result;
 }
 
+void IMAPSession::fetchMessagesByUIDStreaming(String * folder, IMAPMessagesRequestKind requestKind,
+                                              IndexSet * uids, IMAPMessagesStreamCallback * callback,
+                                              IMAPProgressCallback * progressCallback, ErrorCode * pError)
+{
+    struct mailimap_set * imapset = setFromIndexSet(uids);
+    fetchMessages(folder, requestKind, true, imapset, uids, NULL, 0, NULL,
+                  progressCallback, NULL, callback, pError);
+    mailimap_set_free(imapset);
+}
+
 Array * IMAPSession::fetchMessagesByNumber(String * folder, IMAPMessagesRequestKind requestKind,
                                            IndexSet * numbers, IMAPProgressCallback * progressCallback,
                                            ErrorCode * pError)
@@ -2835,7 +3017,7 @@ Array * IMAPSession::fetchMessagesByNumberWithExtraHeaders(String * folder, IMAP
 {
     struct mailimap_set * imapset = setFromIndexSet(numbers);
     IMAPSyncResult * syncResult = fetchMessages(folder, requestKind, false, imapset, NULL, numbers, 0, NULL,
-                                                progressCallback, extraHeaders, pError);
+                                                progressCallback, extraHeaders, NULL, pError);
     if (syncResult == NULL) {
         mailimap_set_free(imapset);
         return NULL;
@@ -3230,6 +3412,65 @@ void IMAPSession::fetchMessageAttachmentToFileByUID(String * folder, uint32_t ui
     * pError = error;
 }
 
+void IMAPSession::fetchMessageToFileByUID(String * folder, uint32_t uid, String * outputFile,
+                                          IMAPProgressCallback * progressCallback, ErrorCode * pError)
+{
+    char * rfc822;
+    size_t rfc822_len;
+    int r;
+
+    selectIfNeeded(folder, pError);
+    if (* pError != ErrorNone)
+        return;
+
+    // The decoder only creates the file once it has bytes to write. Start from
+    // an empty file so that an empty message still produces one.
+    if (Data::data()->writeToFile(outputFile) != ErrorNone) {
+        * pError = ErrorFile;
+        return;
+    }
+
+    DataStreamDecoder * decoder = new DataStreamDecoder();
+    decoder->setEncoding(Encoding8Bit);
+    decoder->setFilename(outputFile);
+
+    mProgressItemsCount = 0;
+    mProgressCallback = progressCallback;
+
+    mailimap_set_msg_body_handler(mImap, msg_body_handler, decoder);
+
+    rfc822 = NULL;
+    rfc822_len = 0;
+    r = fetch_rfc822(mImap, true, uid, &rfc822, &rfc822_len);
+
+    mailimap_set_msg_body_handler(mImap, NULL, NULL);
+    mProgressCallback = NULL;
+
+    if (rfc822 != NULL) {
+        mailimap_nstring_free(rfc822);
+    }
+
+    ErrorCode error = ErrorNone;
+    if (r == MAILIMAP_ERROR_STREAM) {
+        mShouldDisconnect = true;
+        error = ErrorConnection;
+    }
+    else if (r == MAILIMAP_ERROR_PARSE) {
+        mShouldDisconnect = true;
+        error = ErrorParse;
+    }
+    else if (hasError(r)) {
+        error = ErrorFetch;
+    }
+    else {
+        error = decoder->flushData();
+    }
+
+    MC_SAFE_RELEASE(decoder);
+
+    * pError = error;
+}
+
 IndexSet * IMAPSession::search(String * folder, IMAPSearchKind kind, String * searchString, ErrorCode * pError)
 {
     IMAPSearchExpression * expr;
@@ -4267,7 +4508,7 @@ IMAPSyncResult * IMAPSession::syncMessagesByUIDWithExtraHeaders(String * folder,
     IMAPSyncResult * result = fetchMessages(folder, requestKind, true, imapset,
                                             uids, NULL,
                                             modseq, NULL,
-                                            progressCallback, extraHeaders, pError);
+                                            progressCallback, extraHeaders, NULL, pError);
     mailimap_set_free(imapset);
     return result;
 
@@ -4357,6 +4598,9 @@ void IMAPSession::capabilitySetWithSessionState(IndexSet * capabilities)
     if (mailimap_has_extension(mImap, (char *)"XYMHIGHESTMODSEQ")) {
         capabilities->addIndex(IMAPCapabilityXYMHighestModseq);
     }
+    if (mailimap_has_list_status(mImap)) {
+        capabilities->addIndex(IMAPCapabilityListStatus);
+    }
     applyCapabilities(capabilities);
 }
 
@@ -19,6 +19,7 @@ namespace mailcore {
     class IMAPSearchExpression;
     class IMAPFolder;
     class IMAPProgressCallback;
+    class IMAPMessagesStreamCallback;
     class IMAPSyncResult;
     class IMAPFolderStatus;
     class IMAPIdentity;
@@ -70,6 +71,9 @@ namespace mailcore {
 
         virtual void select(String * folder, ErrorCode * pError);
         virtual IMAPFolderStatus * folderStatus(String * folder, ErrorCode * pError);
+        // Status of several folders at once, using LIST-STATUS when available and pipelined
+        // STATUS commands otherwise. Folders the server has no status for are missing from the result.
+        virtual HashMap * /* String -> IMAPFolderStatus */ folderStatuses(Array * /* String */ folders, ErrorCode * pError);
         
         virtual Array * /* IMAPFolder */ fetchSubscribedFolders(ErrorCode * pError);
         virtual Array * /* IMAPFolder */ fetchAllFolders(ErrorCode * pError); // will use xlist if available
@@ -118,12 +122,21 @@ namespace mailcore {
                                                                                 IndexSet * numbers,
                                                                                 IMAPProgressCallback * progressCallback,
                                                                                 Array * extraHeaders, ErrorCode * pError);
+        // Like fetchMessagesByUID, but hands each message to the callback as it
+        // arrives instead of accumulating them in an Array.
+        virtual void fetchMessagesByUIDStreaming(String * folder, IMAPMessagesRequestKind requestKind,
+                                                 IndexSet * uids, IMAPMessagesStreamCallback * callback,
+                                                 IMAPProgressCallback * progressCallback, ErrorCode * pError);
         virtual String * customCommand(String * command, ErrorCode * pError);
 
         virtual Data * fetchMessageByUID(String * folder, uint32_t uid,
                                          IMAPProgressCallback * progressCallback, ErrorCode * pError);
         virtual Data * fetchMessageByNumber(String * folder, uint32_t number,
                                             IMAPProgressCallback * progressCallback, ErrorCode * pError);
+        // Writes the raw message to outputFile as the literal arrives instead of
+        // buffering it in memory.
+        virtual void fetchMessageToFileByUID(String * folder, uint32_t uid, String * outputFile,
+                                             IMAPProgressCallback * progressCallback, ErrorCode * pError);
         virtual Data * fetchMessageAttachmentByUID(String * folder, uint32_t uid, String * partID,
                                                    Encoding encoding, IMAPProgressCallback * progressCallback, ErrorCode * pError);
 
@@ -319,7 +332,8 @@ namespace mailcore {
                                        IndexSet * uidsFilter, IndexSet * numbersFilter,
                                        uint64_t modseq,
                                        HashMap * mapping, IMAPProgressCallback * progressCallback,
-                                       Array * extraHeaders, ErrorCode * pError);
+                                       Array * extraHeaders, IMAPMessagesStreamCallback * streamCallback,
+                                       ErrorCode * pError);
         void capabilitySetWithSessionState(IndexSet * capabilities);
         bool enableFeature(String * feature);
         void enableFeatures();
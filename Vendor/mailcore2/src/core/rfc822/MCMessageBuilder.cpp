@@ -348,6 +348,13 @@ static struct mailmime * mime_from_attachment(MessageBuilder * builder, Attachme
                                  MIME_ENCODED_STR(att->contentDescription()),
                                  data->bytes(), data->length(),
                                  contentTypeParameters);
+            if ((mime != NULL) && (builder != NULL) && builder->isEncodedAttachmentsCacheEnabled()) {
+                // The cached data is already base64 encoded and will be written as is.
+                Data * encoded = builder->encodedDataForAttachment(att, data);
+                mime->mm_data.mm_single->dt_encoded = 1;
+                mime->mm_data.mm_single->dt_data.dt_text.dt_data = encoded->bytes();
+                mime->mm_data.mm_single->dt_data.dt_text.dt_length = encoded->length();
+            }
         }
         if (contentTypeParameters != NULL) {
             clist_free(contentTypeParameters);
@@ -565,6 +572,7 @@ void MessageBuilder::init()
     mBoundaryPrefix = NULL;
     mBoundaries = new Array();
     mCurrentBoundaryIndex = 0;
+    mEncodedAttachments = NULL;
 }
 
 MessageBuilder::MessageBuilder()
@@ -590,6 +598,7 @@ MessageBuilder::~MessageBuilder()
     MC_SAFE_RELEASE(mRelatedAttachments);
     MC_SAFE_RELEASE(mBoundaryPrefix);
     MC_SAFE_RELEASE(mBoundaries);
+    MC_SAFE_RELEASE(mEncodedAttachments);
 }
     
 String * MessageBuilder::description()
@@ -653,6 +662,9 @@ String * MessageBuilder::textBody()
 void MessageBuilder::setAttachments(Array * attachments)
 {
     MC_SAFE_REPLACE_COPY(Array, mAttachments, attachments);
+    if (mEncodedAttachments != NULL) {
+        mEncodedAttachments->removeAllObjects();
+    }
 }
 
 Array * MessageBuilder::attachments()
@@ -674,6 +686,9 @@ void MessageBuilder::addAttachment(Attachment * attachment)
 void MessageBuilder::setRelatedAttachments(Array * attachments)
 {
     MC_SAFE_REPLACE_COPY(Array, mRelatedAttachments, attachments);
+    if (mEncodedAttachments != NULL) {
+        mEncodedAttachments->removeAllObjects();
+    }
 }
 
 Array * MessageBuilder::relatedAttachments()
@@ -702,6 +717,21 @@ String * MessageBuilder::boundaryPrefix()
     return mBoundaryPrefix;
 }
 
+void MessageBuilder::setEncodedAttachmentsCacheEnabled(bool enabled)
+{
+    if (!enabled) {
+        MC_SAFE_RELEASE(mEncodedAttachments);
+    }
+    else if (mEncodedAttachments == NULL) {
+        mEncodedAttachments = new HashMap();
+    }
+}
+
+bool MessageBuilder::isEncodedAttachmentsCacheEnabled()
+{
+    return mEncodedAttachments != NULL;
+}
+
 struct mailmime * MessageBuilder::mimeAndFilterBccAndForEncryption(bool filterBcc, bool forEncryption)
 {
     struct mailmime * htmlPart;
@@ -982,3 +1012,22 @@ void MessageBuilder::setBoundaries(Array * boundaries)
     resetBoundaries();
     mBoundaries->addObjectsFromArray(boundaries);
 }
+
+Data * MessageBuilder::encodedDataForAttachment(Attachment * attachment, Data * data)
+{
+    // Attachments are retained by the builder while cached, so their address is a stable key.
+    Value * key = Value::valueWithUnsignedLongLongValue((unsigned long long) (uintptr_t) attachment);
+    Data * encoded = (Data *) mEncodedAttachments->objectForKey(key);
+    if (encoded != NULL) {
+        return encoded;
+    }
+    
+    MMAPString * str = mmap_string_new("");
+    int col = 0;
+    mailmime_base64_write_mem(str, &col, data->bytes(), data->length());
+    encoded = Data::dataWithBytes(str->str, (unsigned int) str->len);
+    mmap_string_free(str);
+    mEncodedAttachments->setObjectForKey(key, encoded);
+    
+    return encoded;
+}
@@ -37,6 +37,12 @@ namespace mailcore {
         // When boundary needs to be prefixed (to go through spam filters).
         virtual void setBoundaryPrefix(String * boundaryPrefix);
         virtual String * boundaryPrefix();
+
+        // When enabled, the base64 encoding of each attachment is kept and reused
+        // by the following calls to data(), for example when only the body changes
+        // between messages. Attachments must not be modified while it's enabled.
+        virtual void setEncodedAttachmentsCacheEnabled(bool enabled);
+        virtual bool isEncodedAttachmentsCacheEnabled();
         
         virtual Data * data();
         virtual Data * dataForEncryption();
@@ -62,6 +68,7 @@ namespace mailcore {
         virtual String * nextBoundary();
         virtual void resetBoundaries();
         virtual void setBoundaries(Array * boundaries);
+        virtual Data * encodedDataForAttachment(Attachment * attachment, Data * data);
         
     private:
         String * mHTMLBody;
@@ -74,6 +81,7 @@ namespace mailcore {
         struct mailmime * mimeAndFilterBccAndForEncryption(bool filterBcc, bool forEncryption);
         Array * mBoundaries;
         unsigned int mCurrentBoundaryIndex;
+        HashMap * mEncodedAttachments;
     };
     
 };
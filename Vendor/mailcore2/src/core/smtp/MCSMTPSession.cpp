@@ -43,6 +43,7 @@ void SMTPSession::init()
     mConnectionType = ConnectionTypeClear;
     mTimeout = 30;
     mCheckCertificateEnabled = true;
+    mConnectionReuseEnabled = false;
     mUseHeloIPEnabled = false;
     mShouldDisconnect = false;
     mSendingCancelled = false;
@@ -70,6 +71,9 @@ SMTPSession::SMTPSession()
 
 SMTPSession::~SMTPSession()
 {
+    if (mSmtp != NULL) {
+        unsetup();
+    }
     pthread_mutex_destroy(&mConnectionLoggerLock);
     pthread_mutex_destroy(&mCancelLock);
     pthread_mutex_destroy(&mCanCancelLock);
@@ -177,6 +181,16 @@ bool SMTPSession::isCheckCertificateEnabled()
     return mCheckCertificateEnabled;
 }
 
+void SMTPSession::setConnectionReuseEnabled(bool enabled)
+{
+    mConnectionReuseEnabled = enabled;
+}
+
+bool SMTPSession::isConnectionReuseEnabled()
+{
+    return mConnectionReuseEnabled;
+}
+
 bool SMTPSession::checkCertificate()
 {
     if (!isCheckCertificateEnabled())
@@ -853,7 +867,19 @@ void SMTPSession::internalSendMessage(Address * from, Array * recipients, Data *
         esmtp_address_list_add(address_list, (char *) MCUTF8(addr->mailbox()), 0, NULL);
     }
     MCLog("send");
-    if ((mSmtp->esmtp & MAILSMTP_ESMTP_PIPELINING) != 0) {
+    if (mConnectionReuseEnabled) {
+        r = mailesmtp_send(mSmtp, MCUTF8(from->mailbox()), 0, NULL,
+            address_list,
+            messageData->bytes(), messageData->length());
+        CAN_CANCEL_LOCK();
+        mCanCancel = false;
+        CAN_CANCEL_UNLOCK();
+        if (r != MAILSMTP_NO_ERROR) {
+            // The transaction may have been left half-way, start over with a new connection.
+            mShouldDisconnect = true;
+        }
+    }
+    else if ((mSmtp->esmtp & MAILSMTP_ESMTP_PIPELINING) != 0) {
         r = mailesmtp_send_quit_no_disconnect(mSmtp, MCUTF8(from->mailbox()), 0, NULL,
                                               address_list,
                                               messageData->bytes(), messageData->length());
@@ -47,6 +47,12 @@ namespace mailcore {
         virtual void setCheckCertificateEnabled(bool enabled);
         virtual bool isCheckCertificateEnabled();
 
+        // When enabled, the connection stays open after a message is sent so that
+        // following messages skip the connection setup and authentication.
+        // disconnect() must be called once done.
+        virtual void setConnectionReuseEnabled(bool enabled);
+        virtual bool isConnectionReuseEnabled();
+
         virtual String * lastSMTPResponse();
 
         virtual int lastSMTPResponseCode();
@@ -86,6 +92,7 @@ namespace mailcore {
         ConnectionType mConnectionType;
         time_t mTimeout;
         bool mCheckCertificateEnabled;
+        bool mConnectionReuseEnabled;
         bool mUseHeloIPEnabled;
         bool mShouldDisconnect;
         bool mSendingCancelled;
@@ -38,4 +38,5 @@ public class IMAPCapability {
     final public static int IMAPCapabilityXOAuth2 = 33;
     final public static int IMAPCapabilityXYMHighestModseq = 34;
     final public static int IMAPCapabilityGmail = 35;
+    final public static int IMAPCapabilityListStatus = 36;
 }
@@ -79,6 +79,8 @@ extern "C" {
 #define com_libmailcore_IMAPCapability_IMAPCapabilityXYMHighestModseq 34L
 #undef com_libmailcore_IMAPCapability_IMAPCapabilityGmail
 #define com_libmailcore_IMAPCapability_IMAPCapabilityGmail 35L
+#undef com_libmailcore_IMAPCapability_IMAPCapabilityListStatus
+#define com_libmailcore_IMAPCapability_IMAPCapabilityListStatus 36L
 #ifdef __cplusplus
 }
 #endif
@@ -321,7 +321,9 @@ typedef NS_ENUM(NSInteger, MCOIMAPCapability) {
     /** AUTH=XOAUTH2 Capability.*/
     MCOIMAPCapabilityXOAuth2,
     /** X-GM-EXT-1 Capability.*/
-    MCOIMAPCapabilityGmail
+    MCOIMAPCapabilityGmail,
+    /** LIST-STATUS Capability.*/
+    MCOIMAPCapabilityListStatus
 };
 
 /** Error domain for mailcore.*/
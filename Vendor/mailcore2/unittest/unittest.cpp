@@ -333,6 +333,30 @@ static void testMUTF7(void)
     global_success ++;
 }
 
+static void testFlattenHTMLWithMaxLength(void)
+{
+    int failure = 0;
+    int success = 0;
+    // Already decoded to UTF-8, the meta charset must be ignored.
+    String * html = String::stringWithUTF8Characters("<html><head><meta http-equiv=\"Content-Type\" content=\"text/html; charset=iso-8859-1\"></head><body><p>Caf\xc3\xa9 cr\xc3\xa8me br\xc3\xbbl\xc3\xa9e</p></body></html>");
+    String * flattened = html->flattenHTMLWithMaxLength(1000);
+    if (!flattened->isEqual(html->flattenHTML()) || strstr(MCUTF8(flattened), "Caf\xc3\xa9") == NULL) {
+        fprintf(stderr, "current:\n%s\n", MCUTF8(flattened));
+        fprintf(stderr, "expected:\n%s\n", MCUTF8(html->flattenHTML()));
+        failure ++;
+    }
+    else {
+        success ++;
+    }
+    if (failure > 0) {
+        printf("testFlattenHTMLWithMaxLength ok: %i succeeded, %i failed\n", success, failure);
+        global_failure ++;
+        return;
+    }
+    printf("testFlattenHTMLWithMaxLength ok: %i succeeded\n", success);
+    global_success ++;
+}
+
 int main(int argc, char ** argv)
 {
     tzset();
@@ -355,6 +379,7 @@ int main(int argc, char ** argv)
     testCharsetDetection(path->stringByAppendingPathComponent(MCSTR("charset-detection")));
     testSummary(path->stringByAppendingPathComponent(MCSTR("summary")));
     testMUTF7();
+    testFlattenHTMLWithMaxLength();
 
     printf("%i tests succeeded, %i tests failed\n", global_success, global_failure);
 